@@ -28,6 +28,11 @@
 //	modified part of the directory and/or bitmap, we simply discard
 //	the changed version, without writing it back to disk.
 //
+//	What the operations do is reported with LOG (cf. utility.h),
+//	under "files" or, for directory operations, "dirs": failures as
+//	errors, opening, closing, creating and removing as information,
+//	and each read and write only when verbose.
+//
 // 	Our implementation at this point has the following restrictions:
 //
 //	   there is no synchronization for concurrent accesses
@@ -150,7 +155,7 @@ FileSystem::FileSystem(bool format)
         currentThread->SetCurrentDirectory(DirectorySector);
         currentDirectorySector = currentThread->GetCurrentDirectory();
 
-    printf("FileSystem initialized. Current directory: sector %d\n", currentDirectorySector);
+    LOG(LogFiles, LogInfo, ("FileSystem initialized. Current directory: sector %d\n", currentDirectorySector));
 }
 
 
@@ -198,55 +203,55 @@ int FileSystem::GetCurrentDirectory()
 
 int FileSystem::Read(FileHandle file, char *into, int numBytes) {	
 	if (!IsValidHandle(file)) {
-        printf("Error: Invalid file handle %d for read\n", file);
+        LOG(LogFiles, LogError, ("Error: Invalid file handle %d for read\n", file));
         return 0;
     }
 
     if (into == NULL) {
-        printf("Error: Null buffer for read\n");
+        LOG(LogFiles, LogError, ("Error: Null buffer for read\n"));
         return 0;
     }
 
     int bytesRead = openFilesTable[file].openFile->Read(into, numBytes);
     openFilesTable[file].currentPosition += bytesRead;
     
-    printf("Read %d bytes from file '%s' (handle %d)\n", 
-           bytesRead, openFilesTable[file].filename, file);
+    LOG(LogFiles, LogVerbose, ("Read %d bytes from file '%s' (handle %d)\n", 
+           bytesRead, openFilesTable[file].filename, file));
     
     return bytesRead;
 }
 
 int FileSystem::Write(FileHandle file, char *from, int numBytes) {		
 	if(!IsValidHandle(file)){
-        printf("Error: Invalid file handle  %d for write\n",file);
+        LOG(LogFiles, LogError, ("Error: Invalid file handle  %d for write\n",file));
         return 0;
     }
     if (from == NULL){
-        printf("Error Null buffeer for write\n");
+        LOG(LogFiles, LogError, ("Error Null buffeer for write\n"));
         return 0;
     }
     int bytesWritten = openFilesTable[file].openFile->Write(from,numBytes);
     openFilesTable[file].currentPosition += bytesWritten;
-    printf("Wrote %d bytes to file '%s' (handle %d)\n",bytesWritten,openFilesTable[file].filename,file);
+    LOG(LogFiles, LogVerbose, ("Wrote %d bytes to file '%s' (handle %d)\n",bytesWritten,openFilesTable[file].filename,file));
     return bytesWritten;
 }
 
 int FileSystem::ReadAt(FileHandle file, char *into, int numBytes,int position) {
 	if (!IsValidHandle(file)) {
-        printf("Error: Invalid file handle %d for ReadAt\n", file);
+        LOG(LogFiles, LogError, ("Error: Invalid file handle %d for ReadAt\n", file));
         return 0;
     }
 
     if (into == NULL) {
-        printf("Error: Null buffer for ReadAt\n");
+        LOG(LogFiles, LogError, ("Error: Null buffer for ReadAt\n"));
         return 0;
     }
 
     int bytesRead = openFilesTable[file].openFile->ReadAt(into, numBytes,position);
     openFilesTable[file].currentPosition += bytesRead;
     
-    printf("Read %d bytes from file '%s' at position %d (handle %d)\n", 
-           bytesRead, openFilesTable[file].filename, position,file);
+    LOG(LogFiles, LogVerbose, ("Read %d bytes from file '%s' at position %d (handle %d)\n", 
+           bytesRead, openFilesTable[file].filename, position,file));
     
     return bytesRead;
 
@@ -255,19 +260,19 @@ int FileSystem::ReadAt(FileHandle file, char *into, int numBytes,int position) {
 
 int FileSystem::WriteAt(FileHandle file, char *from, int numBytes,int position) {
 	  if (!IsValidHandle(file)) {
-        printf("Error: Invalid file handle %d for WriteAt\n", file);
+        LOG(LogFiles, LogError, ("Error: Invalid file handle %d for WriteAt\n", file));
         return 0;
     }
 
     if (from == NULL) {
-        printf("Error: Null buffer for WriteAt\n");
+        LOG(LogFiles, LogError, ("Error: Null buffer for WriteAt\n"));
         return 0;
     }
 
     int bytesWritten = openFilesTable[file].openFile->WriteAt(from, numBytes, position);
     
-    printf("Wrote %d bytes to file '%s' at position %d (handle %d)\n", 
-           bytesWritten, openFilesTable[file].filename, position, file);
+    LOG(LogFiles, LogVerbose, ("Wrote %d bytes to file '%s' at position %d (handle %d)\n", 
+           bytesWritten, openFilesTable[file].filename, position, file));
     
     return bytesWritten;
     //return file->WriteAt(from,numBytes,position);
@@ -276,12 +281,12 @@ int FileSystem::WriteAt(FileHandle file, char *from, int numBytes,int position)
 
 void FileSystem::Close (FileHandle file){
 	 if (!IsValidHandle(file)) {
-        printf("Error: Invalid file handle %d\n", file);
+        LOG(LogFiles, LogError, ("Error: Invalid file handle %d\n", file));
         return;
     }
 
-    printf("Closing file '%s' (handle %d)\n", 
-           openFilesTable[file].filename, file);
+    LOG(LogFiles, LogInfo, ("Closing file '%s' (handle %d)\n", 
+           openFilesTable[file].filename, file));
     
     // Fermer le fichier
     delete openFilesTable[file].openFile;
@@ -294,7 +299,7 @@ void FileSystem::Close (FileHandle file){
     openFilesTable[file].currentPosition = 0;
 }
 void FileSystem::CloseAll(){
-     printf("Closing all open files...\n");
+     LOG(LogFiles, LogInfo, ("Closing all open files...\n"));
     for (int i = 0; i < MAX_OPEN_FILES; i++) {
         if (openFilesTable[i].inUse) {
             Close(i);
@@ -312,7 +317,7 @@ void FileSystem::TouchOpenedFiles(char * modif){
     {
         if (openFilesTable[i].inUse)
         {
-            printf(" -File '%s' (handle %d) would be modified\n",openFilesTable[i].filename,i);
+            printf(" -File '%s' (handle %d) would be modified\n",openFilesTable[i].filename,(int) i);
 
           
         }
@@ -329,7 +334,7 @@ bool FileSystem::ChangeDirectory(char* name)
 {
     // Vérifier les paramètres d'entrée
     if (name == NULL || strlen(name) == 0) {
-        printf("Error: Invalid directory name\n");
+        LOG(LogDirectories, LogError, ("Error: Invalid directory name\n"));
         return FALSE;
     }
 
@@ -337,19 +342,19 @@ bool FileSystem::ChangeDirectory(char* name)
     
     // Vérifier que le secteur est valide
     if (currentSector < 0 || currentSector >= NumSectors) {
-        printf("Error: Invalid current directory sector %d\n", currentSector);
+        LOG(LogDirectories, LogError, ("Error: Invalid current directory sector %d\n", currentSector));
         return FALSE;
     }
 
     OpenFile *currentDirFile = new OpenFile(currentSector);
     if (currentDirFile == NULL) {
-        printf("Error: Could not open current directory\n");
+        LOG(LogDirectories, LogError, ("Error: Could not open current directory\n"));
         return FALSE;
     }
     
     Directory *currentDirectory = new Directory(NumDirEntries);
     if (currentDirectory == NULL) {
-        printf("Error: Could not create directory object\n");
+        LOG(LogDirectories, LogError, ("Error: Could not create directory object\n"));
         delete currentDirFile;
         return FALSE;
     }
@@ -358,7 +363,7 @@ bool FileSystem::ChangeDirectory(char* name)
 
     int sector = currentDirectory->Find(name);
     if (sector == -1) {
-        printf("Directory %s not found\n", name);
+        LOG(LogDirectories, LogError, ("Directory %s not found\n", name));
         delete currentDirectory;
         delete currentDirFile;
         return FALSE;
@@ -366,7 +371,7 @@ bool FileSystem::ChangeDirectory(char* name)
 
     // Vérifier que c'est bien un répertoire
     if (currentDirectory->GetEntryType(name) != DIR_TYPE) {
-        printf("Error: %s is not a directory\n", name);
+        LOG(LogDirectories, LogError, ("Error: %s is not a directory\n", name));
         delete currentDirectory;
         delete currentDirFile;
         return FALSE;
@@ -374,14 +379,14 @@ bool FileSystem::ChangeDirectory(char* name)
 
     // Vérifier que le nouveau secteur est valide
     if (sector < 0 || sector >= NumSectors) {
-        printf("Error: Invalid target directory sector %d\n", sector);
+        LOG(LogDirectories, LogError, ("Error: Invalid target directory sector %d\n", sector));
         delete currentDirectory;
         delete currentDirFile;
         return FALSE;
     }
 
     SetCurrentDirectory(sector);
-    printf("Changed to directory %s (sector %d)\n", name, sector);
+    LOG(LogDirectories, LogInfo, ("Changed to directory %s (sector %d)\n", name, sector));
     
     delete currentDirectory;
     delete currentDirFile;
@@ -399,22 +404,22 @@ bool FileSystem::CreateDirectory(char *name)
 {
     // Vérifier que le thread courant existe
     if (currentThread == NULL) {
-        printf("Error: No current thread\n");
+        LOG(LogDirectories, LogError, ("Error: No current thread\n"));
         return FALSE;
     }
     
     int parentSector = currentThread->GetCurrentDirectory();
-    printf("DEBUG: CreateDirectory called for '%s' in parent directory sector %d\n", name, parentSector);
+    LOG(LogDirectories, LogVerbose, ("DEBUG: CreateDirectory called for '%s' in parent directory sector %d\n", name, parentSector));
     
     // Vérifier que le secteur parent est valide
     if (parentSector < 0) {
-        printf("Error: Invalid parent directory sector %d\n", parentSector);
+        LOG(LogDirectories, LogError, ("Error: Invalid parent directory sector %d\n", parentSector));
         return FALSE;
     }
     
     OpenFile *parentDirectoryFile = new OpenFile(parentSector);
     if (parentDirectoryFile == NULL) {
-        printf("Error: Could not open parent directory\n");
+        LOG(LogDirectories, LogError, ("Error: Could not open parent directory\n"));
         return FALSE;
     }
     
@@ -430,7 +435,7 @@ bool FileSystem::CreateDirectory(char *name)
 
     if (parentDirectory->Find(name) != -1) {
         success = FALSE; // Un fichier ou répertoire avec ce nom existe déjà
-        printf("Error: Directory or file '%s' already exists\n", name);
+        LOG(LogDirectories, LogError, ("Error: Directory or file '%s' already exists\n", name));
     } else {
         freeMap = new BitMap(NumSectors);
         freeMap->FetchFrom(freeMapFile);
@@ -438,15 +443,15 @@ bool FileSystem::CreateDirectory(char *name)
 
         if (sector == -1) {
             success = FALSE; // Pas de secteurs libres
-            printf("Error: No free sectors available\n");
+            LOG(LogDirectories, LogError, ("Error: No free sectors available\n"));
         } else if (!parentDirectory->Add(name, sector, DIR_TYPE)) {
             success = FALSE; // Plus de place dans le répertoire parent
-            printf("Error: No space in parent directory\n");
+            LOG(LogDirectories, LogError, ("Error: No space in parent directory\n"));
         } else {
             hdr = new FileHeader;
             if (!hdr->Allocate(freeMap, DirectoryFileSize)) {
                 success = FALSE; // Pas assez d'espace pour les données
-                printf("Error: Not enough space for directory data\n");
+                LOG(LogDirectories, LogError, ("Error: Not enough space for directory data\n"));
             } else {
                 success = TRUE;
                 
@@ -466,7 +471,7 @@ bool FileSystem::CreateDirectory(char *name)
                 parentDirectory->WriteBack(parentDirectoryFile);
                 freeMap->WriteBack(freeMapFile);
                 
-                printf("Directory '%s' created successfully at sector %d\n", name, sector);
+                LOG(LogDirectories, LogInfo, ("Directory '%s' created successfully at sector %d\n", name, sector));
                 
                 delete newDirectory;
                 delete newDirFile;
@@ -521,12 +526,12 @@ bool FileSystem::Create(char *name, int initialSize)
 
     // Vérifier les paramètres d'entrée
     if (name == NULL || strlen(name) == 0) {
-        printf("Error: Invalid file name\n");
+        LOG(LogFiles, LogError, ("Error: Invalid file name\n"));
         return FALSE;
     }
     
     if (initialSize < 0) {
-        printf("Error: Invalid file size %d\n", initialSize);
+        LOG(LogFiles, LogError, ("Error: Invalid file size %d\n", initialSize));
         return FALSE;
     }
 
@@ -534,19 +539,19 @@ bool FileSystem::Create(char *name, int initialSize)
     
     // Vérifier que le secteur est valide
     if (currentSector < 0 || currentSector >= NumSectors) {
-        printf("Error: Invalid current directory sector %d\n", currentSector);
+        LOG(LogFiles, LogError, ("Error: Invalid current directory sector %d\n", currentSector));
         return FALSE;
     }
 
     OpenFile *currentDirFile = new OpenFile(currentSector);
     if (currentDirFile == NULL) {
-        printf("Error: Could not open current directory\n");
+        LOG(LogFiles, LogError, ("Error: Could not open current directory\n"));
         return FALSE;
     }
     
     Directory *directory = new Directory(NumDirEntries);
     if (directory == NULL) {
-        printf("Error: Could not create directory object\n");
+        LOG(LogFiles, LogError, ("Error: Could not create directory object\n"));
         delete currentDirFile;
         return FALSE;
     }
@@ -561,32 +566,32 @@ bool FileSystem::Create(char *name, int initialSize)
     directory->FetchFrom(currentDirFile);
 
     if (directory->Find(name) != -1) {
-        printf("Error: File %s already exists\n", name);
+        LOG(LogFiles, LogError, ("Error: File %s already exists\n", name));
         success = FALSE;			// file is already in directory
     } else {    
         freeMap = new BitMap(NumSectors);
         if (freeMap == NULL) {
-            printf("Error: Could not create bitmap\n");
+            LOG(LogFiles, LogError, ("Error: Could not create bitmap\n"));
             success = FALSE;
         } else {
             freeMap->FetchFrom(freeMapFile);
             sector = freeMap->Find();	// find a sector to hold the file header
 
             if (sector == -1) {
-                printf("Error: No free sectors available\n");
+                LOG(LogFiles, LogError, ("Error: No free sectors available\n"));
                 success = FALSE;		// no free block for file header
 
             } else if (!directory->Add(name, sector, FILE_TYPE)) {
-                printf("Error: No space in directory\n");
+                LOG(LogFiles, LogError, ("Error: No space in directory\n"));
                 success = FALSE; // no space in directory
             } else {
                 hdr = new FileHeader;
                 if (hdr == NULL) {
-                    printf("Error: Could not create file header\n");
+                    LOG(LogFiles, LogError, ("Error: Could not create file header\n"));
                     success = FALSE;  // could not create file header
                 } else {
                     if (!hdr->Allocate(freeMap, initialSize)) {
-                        printf("Error: Not enough space for file data\n");
+                        LOG(LogFiles, LogError, ("Error: Not enough space for file data\n"));
                         success = FALSE; // no space on disk for data
                     } else {    
                         success = TRUE;
@@ -636,14 +641,14 @@ static char* getNextPathComponent(char **path) {
 FileHandle FileSystem::Open(char *name)
 { 
      if (name == NULL || strlen(name) == 0) {
-        printf("Error: Invalid file name\n");
+        LOG(LogFiles, LogError, ("Error: Invalid file name\n"));
         return INVALID_FILE_HANDLE;
     }
 
     int currentSector = GetCurrentDirectory();
     OpenFile *currentDirFile = new OpenFile(currentSector);
     if (currentDirFile == NULL) {
-        printf("Error: Could not open current directory sector %d\n", currentSector);
+        LOG(LogFiles, LogError, ("Error: Could not open current directory sector %d\n", currentSector));
         return INVALID_FILE_HANDLE;
     }
     
@@ -653,7 +658,7 @@ FileHandle FileSystem::Open(char *name)
     int sector = directory->Find(name); 
     
     if (sector == -1) {
-        printf("File '%s' not found in directory\n", name);
+        LOG(LogFiles, LogError, ("File '%s' not found in directory\n", name));
         delete directory;
         delete currentDirFile;
         return INVALID_FILE_HANDLE;
@@ -662,7 +667,7 @@ FileHandle FileSystem::Open(char *name)
     // Vérifier si le fichier est déjà ouvert
     for (int i = 0; i < MAX_OPEN_FILES; i++) {
         if (openFilesTable[i].inUse && openFilesTable[i].sector == sector) {
-            printf("File '%s' is already open (handle %d)\n", name, i);
+            LOG(LogFiles, LogInfo, ("File '%s' is already open (handle %d)\n", name, i));
             delete directory;
             delete currentDirFile;
             return i;  // Retourner le handle existant
@@ -672,7 +677,7 @@ FileHandle FileSystem::Open(char *name)
     // Trouver un slot libre
     FileHandle handle = FindFreeSlot();
     if (handle == INVALID_FILE_HANDLE) {
-        printf("Error: Open files table is full (max %d files)\n", MAX_OPEN_FILES);
+        LOG(LogFiles, LogError, ("Error: Open files table is full (max %d files)\n", MAX_OPEN_FILES));
         delete directory;
         delete currentDirFile;
         return INVALID_FILE_HANDLE;
@@ -681,7 +686,7 @@ FileHandle FileSystem::Open(char *name)
     // Ouvrir le fichier
     OpenFile *file = new OpenFile(sector);
     if (file == NULL) {
-        printf("Error: Could not open file at sector %d\n", sector);
+        LOG(LogFiles, LogError, ("Error: Could not open file at sector %d\n", sector));
         delete directory;
         delete currentDirFile;
         return INVALID_FILE_HANDLE;
@@ -695,7 +700,7 @@ FileHandle FileSystem::Open(char *name)
     openFilesTable[handle].filename[31] = '\0';
     openFilesTable[handle].currentPosition = 0;
 
-    printf("File '%s' opened successfully (handle %d, sector %d)\n", name, handle, sector);
+    LOG(LogFiles, LogInfo, ("File '%s' opened successfully (handle %d, sector %d)\n", name, handle, sector));
     
     delete directory;
     delete currentDirFile;
@@ -721,7 +726,7 @@ bool FileSystem::Remove(char *name)
 { 
     // Vérifier les paramètres d'entrée
     if (name == NULL || strlen(name) == 0) {
-        printf("Error: Invalid file name\n");
+        LOG(LogFiles, LogError, ("Error: Invalid file name\n"));
         return FALSE;
     }
 
@@ -729,19 +734,19 @@ bool FileSystem::Remove(char *name)
     
     // Vérifier que le secteur est valide
     if (currentSector < 0 || currentSector >= NumSectors) {
-        printf("Error: Invalid current directory sector %d\n", currentSector);
+        LOG(LogFiles, LogError, ("Error: Invalid current directory sector %d\n", currentSector));
         return FALSE;
     }
 
     OpenFile *currentDirFile = new OpenFile(currentSector);
     if (currentDirFile == NULL) {
-        printf("Error: Could not open current directory\n");
+        LOG(LogFiles, LogError, ("Error: Could not open current directory\n"));
         return FALSE;
     }
     //
     Directory *directory = new Directory(NumDirEntries);
     if (directory == NULL) {
-        printf("Error: Could not create directory object\n");
+        LOG(LogFiles, LogError, ("Error: Could not create directory object\n"));
         delete currentDirFile;
         return FALSE;
     }
@@ -754,7 +759,7 @@ bool FileSystem::Remove(char *name)
     
     sector = directory->Find(name);
     if (sector == -1) {
-        printf("File %s not found\n", name);
+        LOG(LogFiles, LogError, ("File %s not found\n", name));
         delete directory;
         delete currentDirFile;
         return FALSE; // file not found
@@ -762,7 +767,7 @@ bool FileSystem::Remove(char *name)
         
     fileHdr = new FileHeader;
     if (fileHdr == NULL) {
-        printf("Error: Could not create file header\n");
+        LOG(LogFiles, LogError, ("Error: Could not create file header\n"));
         delete directory;
         delete currentDirFile;
         return FALSE;
@@ -772,7 +777,7 @@ bool FileSystem::Remove(char *name)
     
     freeMap = new BitMap(NumSectors);
     if (freeMap == NULL) {
-        printf("Error: Could not create bitmap\n");
+        LOG(LogFiles, LogError, ("Error: Could not create bitmap\n"));
         delete fileHdr;
         delete directory;
         delete currentDirFile;
@@ -793,7 +798,7 @@ bool FileSystem::Remove(char *name)
     delete freeMap;
     delete currentDirFile;
     
-    printf("File %s removed successfully\n", name);
+    LOG(LogFiles, LogInfo, ("File %s removed successfully\n", name));
     return TRUE;
 }
 
@@ -808,19 +813,19 @@ void FileSystem::List()
     
     // Vérifier que le secteur est valide
     if (currentSector < 0 || currentSector >= NumSectors) {
-        printf("Error: Invalid current directory sector %d\n", currentSector);
+        LOG(LogDirectories, LogError, ("Error: Invalid current directory sector %d\n", currentSector));
         return;
     }
 
     OpenFile *currentDirFile = new OpenFile(currentSector);
     if (currentDirFile == NULL) {
-        printf("Error: Could not open current directory\n");
+        LOG(LogDirectories, LogError, ("Error: Could not open current directory\n"));
         return;
     }
     
     Directory *directory = new Directory(NumDirEntries);
     if (directory == NULL) {
-        printf("Error: Could not create directory object\n");
+        LOG(LogDirectories, LogError, ("Error: Could not create directory object\n"));
         delete currentDirFile;
         return;
     }
@@ -20,6 +20,7 @@
 #include "thread.h"
 #include "disk.h"
 #include "stats.h"
+#include "filehdr.h"
 
 #define TransferSize 	10 	// make it small, just to be difficult
 
@@ -111,12 +112,21 @@ Print(char *name)
 //	  FileWrite -- write the file
 //	  FileRead -- read the file
 //	  PerformanceTest -- overall control, and print out performance #'s
+//
+//	Files can't grow, and can't be bigger than MaxFileSize, so we
+//	create the biggest file that fits, and write and read it NumPasses
+//	times over -- about 5000 chunks each way.
+//
+//	Besides the simulated time, we print how long the test took on
+//	the host, which is mostly Nachos' own overhead (with -lv
+//	files=verbose, say, it includes logging every read and write).
 //----------------------------------------------------------------------
 
 #define FileName 	"TestFile"
 #define Contents 	"1234567890"
-#define ContentSize 	strlen(Contents)
-#define FileSize 	((int)(ContentSize * 5000))
+#define ContentSize 	((int) strlen(Contents))
+#define FileSize 	((int)((MaxFileSize / ContentSize) * ContentSize))
+#define NumPasses	13
 
 static void 
 FileWrite()
@@ -124,14 +134,8 @@ FileWrite()
     FileHandle openFile;    
     int i, numBytes;
 
-    printf("Sequential write of %d byte file, in %d byte chunks\n", 
-	FileSize, ContentSize);
-    if (!fileSystem->Create(FileName, 0)) {
-      printf("Perf test: can't create %s\n", FileName);
-      return;
-    }
     openFile = fileSystem->Open(FileName);
-    if (openFile == NULL) {
+    if (openFile == INVALID_FILE_HANDLE) {
 	printf("Perf test: unable to open %s\n", FileName);
 	return;
     }
@@ -153,10 +157,7 @@ FileRead()
     char *buffer = new char[ContentSize];
     int i, numBytes;
 
-    printf("Sequential read of %d byte file, in %d byte chunks\n", 
-	FileSize, ContentSize);
-
-    if ((openFile = fileSystem->Open(FileName)) == NULL) {
+    if ((openFile = fileSystem->Open(FileName)) == INVALID_FILE_HANDLE) {
 	printf("Perf test: unable to open file %s\n", FileName);
 	delete [] buffer;
 	return;
@@ -177,15 +178,34 @@ FileRead()
 void
 PerformanceTest()
 {
+    double start, writing = 0, reading = 0;
+
     printf("Starting file system performance test:\n");
     stats->Print();
-    FileWrite();
-    FileRead();
+    start = HostSeconds();
+    if (!fileSystem->Create(FileName, FileSize)) {
+      printf("Perf test: can't create %s\n", FileName);
+      return;
+    }
+    printf("Sequential write and read of %d byte file, in %d byte chunks, "
+	"%d times\n", FileSize, ContentSize, NumPasses);
+    for (int i = 0; i < NumPasses; i++) {
+	double passStart = HostSeconds();
+
+	FileWrite();
+	writing += HostSeconds() - passStart;
+	passStart = HostSeconds();
+	FileRead();
+	reading += HostSeconds() - passStart;
+    }
     if (!fileSystem->Remove(FileName)) {
       printf("Perf test: unable to remove %s\n", FileName);
       return;
     }
     stats->Print();
+    printf("Host time: write %.3f ms, read %.3f ms, total %.3f ms\n",
+	writing * 1000, reading * 1000,
+	(HostSeconds() - start) * 1000);
 }
 
 void
@@ -397,7 +417,7 @@ TabSysTest()
 //
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 void
-TabPcsTest1(int No)
+TabPcsTest1(intptr_t No)
 {	
 	// Thread 1 du test #2 pour table fichiers ouverts
    
@@ -421,7 +441,7 @@ TabPcsTest1(int No)
 }
 	
 void
-TabPcsTest2(int No)
+TabPcsTest2(intptr_t No)
 {	
 	// Thread 2 du test #2 pour table fichiers ouverts
    
@@ -448,7 +468,7 @@ TabPcsTest2(int No)
 
 
 void
-TabPcsTest3(int No)
+TabPcsTest3(intptr_t No)
 {	
 	// Thread 3 du test #2 pour table fichiers ouverts
    
@@ -16,6 +16,7 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // DiskRequestDone
@@ -24,7 +25,7 @@
 //----------------------------------------------------------------------
 
 static void
-DiskRequestDone (int arg)
+DiskRequestDone (intptr_t arg)
 {
     SynchDisk* disk = (SynchDisk *)arg;
 
@@ -44,7 +45,8 @@ SynchDisk::SynchDisk(char* name)
 {
     semaphore = new Semaphore("synch disk", 0);
     lock = new Lock("synch disk lock");
-    disk = new Disk(name, DiskRequestDone, (int) this);
+    disk = new Disk(name, DiskRequestDone, (intptr_t) this);
+    requestSubmitted = 0;
 }
 
 //----------------------------------------------------------------------
@@ -72,7 +74,10 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
+    int submitted = stats->totalTicks;
+
     lock->Acquire();			// only one disk I/O at a time
+    Dispatch(submitted);
     disk->ReadRequest(sectorNumber, data);
     semaphore->P();			// wait for interrupt
     lock->Release();
@@ -90,7 +95,10 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
+    int submitted = stats->totalTicks;
+
     lock->Acquire();			// only one disk I/O at a time
+    Dispatch(submitted);
     disk->WriteRequest(sectorNumber, data);
     semaphore->P();			// wait for interrupt
     lock->Release();
@@ -105,5 +113,23 @@ SynchDisk::WriteSector(int sectorNumber, char* data)
 void
 SynchDisk::RequestDone()
 { 
+    if (stats->keepDiskLatency)
+	stats->diskResponse.Record(stats->totalTicks - requestSubmitted);
     semaphore->V();
 }
+
+//----------------------------------------------------------------------
+// SynchDisk::Dispatch
+// 	With -dh, count how long the request handed to us at "submitted"
+//	waited for the disk, now that it is about to be sent, and remember
+//	when it started, for its response time.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Dispatch(int submitted)
+{
+    if (!stats->keepDiskLatency)
+	return;
+    stats->diskQueueWait.Record(stats->totalTicks - submitted);
+    requestSubmitted = submitted;
+}
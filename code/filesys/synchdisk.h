@@ -42,12 +42,23 @@ class SynchDisk {
 					// handler, to signal that the
 					// current disk operation is complete.
 
+    void Checkpoint(int fd) { disk->Checkpoint(fd); }
+    void Restore(int fd) { disk->Restore(fd); }
+					// Save/restore the raw disk; only
+					// while no request is outstanding
+
   private:
+    void Dispatch(int submitted);	// Note, if -dh, how long a request
+					// handed to us at "submitted" waited
+					// to be sent to the disk
+
     Disk *disk;		  		// Raw disk device
     Semaphore *semaphore; 		// To synchronize requesting thread 
 					// with the interrupt handler
     Lock *lock;		  		// Only one read/write request
 					// can be sent to the disk at a time
+    int requestSubmitted;		// When the request being served was
+					// handed to us
 };
 
 #endif // SYNCHDISK_H
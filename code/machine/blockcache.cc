@@ -0,0 +1,128 @@
+// blockcache.cc
+//	Routines to translate user code into blocks of decoded
+//	instructions, and to keep track of them.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "blockcache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// TranslatedBlock::TranslatedBlock
+// 	Decode a block of user instructions.
+//
+//	"code" -- the instructions, in the simulated machine's format
+//	"numInstrs" -- how many there are
+//----------------------------------------------------------------------
+
+TranslatedBlock::TranslatedBlock(char *code, int numInstrs)
+{
+    int i;
+
+    ASSERT((numInstrs > 0) && (numInstrs <= MaxBlockLength));
+    length = numInstrs;
+    for (i = 0; i < length; i++) {
+	instr[i].value = WordToHost(*(unsigned int *) &code[i * 4]);
+	instr[i].Decode();
+    }
+    for (i = 0; i < length; i++)
+	Pair(i);
+}
+
+//----------------------------------------------------------------------
+// TranslatedBlock::Pair
+// 	Note whether instruction "i" and the one after it can be run
+//	together.  The last instruction has nothing after it in the block.
+//----------------------------------------------------------------------
+
+void
+TranslatedBlock::Pair(int i)
+{
+    fused[i] = (i + 1 < length) && instr[i].FusesWith(&instr[i + 1]);
+}
+
+//----------------------------------------------------------------------
+// BlockCache::BlockCache
+// 	Initialize the cache of translated blocks; there are none yet.
+//
+//	"mainMemory" -- the physical memory the user code is in
+//----------------------------------------------------------------------
+
+BlockCache::BlockCache(char *mainMemory)
+{
+    int i;
+
+    memory = mainMemory;
+    blocks = new TranslatedBlock *[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++)
+	blocks[i] = NULL;
+}
+
+//----------------------------------------------------------------------
+// BlockCache::~BlockCache
+// 	De-allocate the translated blocks.
+//----------------------------------------------------------------------
+
+BlockCache::~BlockCache()
+{
+    int i;
+
+    for (i = 0; i < MemorySize / 4; i++)
+	delete blocks[i];
+    delete [] blocks;
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Find
+// 	Return the block of instructions from physAddr to the end of
+//	its page, translating it the first time it is asked for.
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+BlockCache::Find(int physAddr)
+{
+    int length;
+
+    ASSERT(((physAddr & 0x3) == 0) && (physAddr >= 0) &&
+						(physAddr < MemorySize));
+    if (blocks[physAddr / 4] == NULL) {
+	length = (PageSize - (physAddr % PageSize)) / 4;
+	blocks[physAddr / 4] = new TranslatedBlock(&memory[physAddr],
+								length);
+    }
+    return blocks[physAddr / 4];
+}
+
+//----------------------------------------------------------------------
+// BlockCache::Retranslate
+// 	Decode instruction "i" of "block", whose word in memory (at
+//	physAddr) has changed since it was translated -- a new program
+//	has been loaded there, say.  The words after it have most likely
+//	changed too, so decode those that have while we are at it; then
+//	note again which of the instructions pair up, from the one before.
+//----------------------------------------------------------------------
+
+void
+BlockCache::Retranslate(TranslatedBlock *block, int i, int physAddr)
+{
+    int last = i;
+    unsigned int word;
+
+    for (;;) {
+	block->instr[last].value = 
+			WordToHost(*(unsigned int *) &memory[physAddr]);
+	block->instr[last].Decode();
+	if (last + 1 == block->length)
+	    break;
+	physAddr += 4;
+	word = WordToHost(*(unsigned int *) &memory[physAddr]);
+	if (block->instr[last + 1].value == word)
+	    break;
+	last++;
+    }
+    for (i = (i > 0) ? i - 1 : 0; i <= last; i++)
+	block->Pair(i);
+}
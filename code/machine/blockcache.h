@@ -0,0 +1,82 @@
+// blockcache.h
+//	Data structures for running user code from translated blocks
+//	(see Machine::RunTranslated), instead of fetching, translating
+//	and decoding every instruction each time it is executed.
+//
+//	A block is the user code from an entry point (the target of a
+//	jump, say) to the end of its page, already decoded.  Blocks are
+//	found by the physical address of their entry point; since they
+//	never cross a page, the page table only needs to be consulted
+//	when entering one.
+//
+//	The block also notes which instructions start a pair that can be
+//	run in one step (see Machine::ExecutePair) with the next one.
+//
+//	Each decoded instruction remembers the word it was decoded from,
+//	and is decoded again if memory no longer holds that word (along
+//	with whether it pairs with its neighbours).  So nobody has to
+//	tell us when the kernel loads a new program into memory, or when
+//	a program rewrites its own code.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define MaxBlockLength	(PageSize / 4)	// a block holds at most a page
+
+// The following class defines a translated block.
+
+class TranslatedBlock {
+  public:
+    TranslatedBlock(char *code, int numInstrs);
+				// Translate "numInstrs" instructions at
+				// "code"
+
+    int length;			// number of instructions in the block
+    Instruction instr[MaxBlockLength];	// ... and the instructions,
+				// decoded; instr[i].value is the word
+				// it was decoded from
+    bool fused[MaxBlockLength];	// does instr[i] pair with instr[i + 1]?
+
+    void Pair(int i);		// Set fused[i] from the instructions
+};
+
+// The following class defines the collection of all translated blocks,
+// one for each word of physical memory that was ever jumped to.
+
+class BlockCache {
+  public:
+    BlockCache(char *mainMemory);	// Initialize an empty cache of
+				// blocks translated from "mainMemory"
+    ~BlockCache();		// De-allocate all the blocks
+
+    TranslatedBlock *Find(int physAddr);
+				// Return the block starting at physAddr,
+				// translating it if need be
+    Instruction *Fetch(TranslatedBlock *block, int physAddr, int i) {
+	if (block->instr[i].value !=
+			WordToHost(*(unsigned int *) &memory[physAddr]))
+	    Retranslate(block, i, physAddr);
+	return &block->instr[i];
+    }				// Return instruction "i" of "block", found
+				// at physAddr, making sure it is still
+				// what is in memory there
+
+  private:
+    char *memory;		// the machine's main memory
+    TranslatedBlock **blocks;	// the block for each word of memory,
+				// NULL if none yet
+
+    void Retranslate(TranslatedBlock *block, int i, int physAddr);
+				// Decode again an instruction that has
+				// changed in memory, and any changed ones
+				// right after it
+};
+
+#endif // BLOCKCACHE_H
@@ -18,9 +18,9 @@
 #include "system.h"
 
 // Dummy functions because C++ is weird about pointers to member functions
-static void ConsoleReadPoll(int c) 
+static void ConsoleReadPoll(intptr_t c) 
 { Console *console = (Console *)c; console->CheckCharAvail(); }
-static void ConsoleWriteDone(int c)
+static void ConsoleWriteDone(intptr_t c)
 { Console *console = (Console *)c; console->WriteDone(); }
 
 //----------------------------------------------------------------------
@@ -37,7 +37,7 @@ static void ConsoleWriteDone(int c)
 //----------------------------------------------------------------------
 
 Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail, 
-		VoidFunctionPtr writeDone, int callArg)
+		VoidFunctionPtr writeDone, intptr_t callArg)
 {
     if (readFile == NULL)
 	readFileNo = 0;					// keyboard = stdin
@@ -56,7 +56,7 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     incoming = EOF;
 
     // start polling for incoming packets
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, ConsoleReadInt);
+    interrupt->Schedule(ConsoleReadPoll, (intptr_t) this, ConsoleTime, ConsoleReadInt);
 }
 
 //----------------------------------------------------------------------
@@ -89,15 +89,26 @@ Console::CheckCharAvail()
     char c;
 
     // schedule the next time to poll for a packet
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
+    interrupt->Schedule(ConsoleReadPoll, (intptr_t) this, ConsoleTime, 
 			ConsoleReadInt);
 
-    // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
-
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
+    // do nothing if character is already buffered
+    if (incoming != EOF)
+	return;
+
+    // when replaying, the character comes from the event log 
+    if ((eventLog != NULL) && eventLog->IsReplaying()) {
+	if (!eventLog->Replay(ConsoleInputEvent, &c, sizeof(char)))
+	    return;
+    } else {
+	if (!PollFile(readFileNo))	// do nothing if none to be read
+	    return;
+	Read(readFileNo, &c, sizeof(char));
+	if (eventLog != NULL)
+	    eventLog->Record(ConsoleInputEvent, &c, sizeof(char));
+    }
+
+    // tell user about the character
     incoming = c ;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);	
@@ -145,6 +156,6 @@ Console::PutChar(char ch)
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
     putBusy = TRUE;
-    interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
+    interrupt->Schedule(ConsoleWriteDone, (intptr_t) this, ConsoleTime,
 					ConsoleWriteInt);
 }
@@ -26,7 +26,7 @@
 #define DiskSize 	(MagicSize + (NumSectors * SectorSize))
 
 // dummy procedure because we can't take a pointer of a member function
-static void DiskDone(int arg) { ((Disk *)arg)->HandleInterrupt(); }
+static void DiskDone(intptr_t arg) { ((Disk *)arg)->HandleInterrupt(); }
 
 //----------------------------------------------------------------------
 // Disk::Disk()
@@ -40,7 +40,7 @@ static void DiskDone(int arg) { ((Disk *)arg)->HandleInterrupt(); }
 //	"callArg" -- argument to pass the interrupt handler
 //----------------------------------------------------------------------
 
-Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
+Disk::Disk(char* name, VoidFunctionPtr callWhenDone, intptr_t callArg)
 {
     int magicNum;
     int tmp = 0;
@@ -78,6 +78,48 @@ Disk::~Disk()
     Close(fileno);
 }
 
+//----------------------------------------------------------------------
+// Disk::Checkpoint
+// 	Save the whole disk image, along with the state that decides how
+//	long the next request will take, to the open UNIX file "fd".
+//	There must be no request in progress.
+//----------------------------------------------------------------------
+
+void
+Disk::Checkpoint(int fd)
+{
+    char *image = new char[DiskSize];
+
+    ASSERT(!active);
+    WriteFile(fd, (char *) &lastSector, sizeof(int));
+    WriteFile(fd, (char *) &bufferInit, sizeof(int));
+    Lseek(fileno, 0, 0);
+    Read(fileno, image, DiskSize);
+    WriteFile(fd, image, DiskSize);
+    delete [] image;
+}
+
+//----------------------------------------------------------------------
+// Disk::Restore
+// 	Overwrite the disk, and its head and track buffer state, with
+//	what Checkpoint saved.
+//----------------------------------------------------------------------
+
+void
+Disk::Restore(int fd)
+{
+    char *image = new char[DiskSize];
+
+    ASSERT(!active);
+    Read(fd, (char *) &lastSector, sizeof(int));
+    Read(fd, (char *) &bufferInit, sizeof(int));
+    Read(fd, image, DiskSize);
+    ASSERT(*(int *) image == MagicNumber);
+    Lseek(fileno, 0, 0);
+    WriteFile(fileno, image, DiskSize);
+    delete [] image;
+}
+
 //----------------------------------------------------------------------
 // Disk::PrintSector()
 // 	Dump the data in a disk read/write request, for debugging.
@@ -115,12 +157,16 @@ PrintSector (bool writing, int sector, char *data)
 void
 Disk::ReadRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
+    int seek, rotation;
+    bool bufferHit;
+    int ticks = ComputeLatency(sectorNumber, FALSE, &seek, &rotation, 
+								&bufferHit);
 
     ASSERT(!active);				// only one request at a time
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
     DEBUG('d', "Reading from sector %d\n", sectorNumber);
+    TRACE(TraceDiskRead, sectorNumber);
     Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
     Read(fileno, data, SectorSize);
     if (DebugIsEnabled('d'))
@@ -129,18 +175,25 @@ Disk::ReadRequest(int sectorNumber, char* data)
     active = TRUE;
     UpdateLast(sectorNumber);
     stats->numDiskReads++;
-    interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
+    if (stats->keepDiskLatency)
+	stats->RecordDiskRequest(seek, rotation, ticks - seek - rotation,
+								bufferHit);
+    interrupt->Schedule(DiskDone, (intptr_t) this, ticks, DiskInt);
 }
 
 void
 Disk::WriteRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
+    int seek, rotation;
+    bool bufferHit;
+    int ticks = ComputeLatency(sectorNumber, TRUE, &seek, &rotation, 
+								&bufferHit);
 
     ASSERT(!active);
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
     DEBUG('d', "Writing to sector %d\n", sectorNumber);
+    TRACE(TraceDiskWrite, sectorNumber);
     Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
     WriteFile(fileno, data, SectorSize);
     if (DebugIsEnabled('d'))
@@ -149,7 +202,10 @@ Disk::WriteRequest(int sectorNumber, char* data)
     active = TRUE;
     UpdateLast(sectorNumber);
     stats->numDiskWrites++;
-    interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
+    if (stats->keepDiskLatency)
+	stats->RecordDiskRequest(seek, rotation, ticks - seek - rotation,
+								bufferHit);
+    interrupt->Schedule(DiskDone, (intptr_t) this, ticks, DiskInt);
 }
 
 //----------------------------------------------------------------------
@@ -162,6 +218,7 @@ void
 Disk::HandleInterrupt ()
 { 
     active = FALSE;
+    TRACE(TraceDiskDone, lastSector);
     (*handler)(handlerArg);
 }
 
@@ -230,18 +287,27 @@ Disk::ModuloDiff(int to, int from)
 //----------------------------------------------------------------------
 
 int
-Disk::ComputeLatency(int newSector, bool writing)
+Disk::ComputeLatency(int newSector, bool writing, int *seekTime,
+			int *rotationTime, bool *bufferHit)
 {
     int rotation;
     int seek = TimeToSeek(newSector, &rotation);
     int timeAfter = stats->totalTicks + seek + rotation;
 
+    if (bufferHit != NULL)
+	*bufferHit = FALSE;
 #ifndef NOTRACKBUF	// turn this on if you don't want the track buffer stuff
     // check if track buffer applies
     if ((writing == FALSE) && (seek == 0) 
 		&& (((timeAfter - bufferInit) / RotationTime) 
 	     		> ModuloDiff(newSector, bufferInit / RotationTime))) {
         DEBUG('d', "Request latency = %d\n", RotationTime);
+	if (seekTime != NULL)
+	    *seekTime = 0;
+	if (rotationTime != NULL)
+	    *rotationTime = 0;
+	if (bufferHit != NULL)
+	    *bufferHit = TRUE;
 	return RotationTime; // time to transfer sector from the track buffer
     }
 #endif
@@ -249,6 +315,10 @@ Disk::ComputeLatency(int newSector, bool writing)
     rotation += ModuloDiff(newSector, timeAfter / RotationTime) * RotationTime;
 
     DEBUG('d', "Request latency = %d\n", seek + rotation + RotationTime);
+    if (seekTime != NULL)
+	*seekTime = seek;
+    if (rotationTime != NULL)
+	*rotationTime = rotation;
     return(seek + rotation + RotationTime);
 }
 
@@ -54,7 +54,7 @@
 
 class Disk {
   public:
-    Disk(char* name, VoidFunctionPtr callWhenDone, int callArg);
+    Disk(char* name, VoidFunctionPtr callWhenDone, intptr_t callArg);
     					// Create a simulated disk.  
 					// Invoke (*callWhenDone)(callArg) 
 					// every time a request completes.
@@ -70,16 +70,23 @@ class Disk {
     void HandleInterrupt();		// Interrupt handler, invoked when
 					// disk request finishes.
 
-    int ComputeLatency(int newSector, bool writing);	
+    int ComputeLatency(int newSector, bool writing, int *seek = NULL,
+			int *rotation = NULL, bool *bufferHit = NULL);
     					// Return how long a request to 
 					// newSector will take: 
 					// (seek + rotational delay + transfer)
+					// and, if asked, the first two, and
+					// whether the track buffer has it
+
+    void Checkpoint(int fd);		// Save/restore the disk contents,
+    void Restore(int fd);		// and the head and track buffer
+					// state, to/from an open UNIX file
 
   private:
     int fileno;				// UNIX file number for simulated disk 
     VoidFunctionPtr handler;		// Interrupt handler, to be invoked 
 					// when any disk request finishes
-    int handlerArg;			// Argument to interrupt handler 
+    intptr_t handlerArg;		// Argument to interrupt handler 
     bool active;     			// Is a disk operation in progress?
     int lastSector;			// The previous disk request 
     int bufferInit;			// When the track buffer started 
@@ -0,0 +1,228 @@
+// eventlog.cc
+//	Routines to record and replay the inputs to a Nachos run.
+//
+//	The log is a sequence of events, in the order they happened:
+//	the simulated time, the event type, the number of data bytes,
+//	and then the data itself.  Since the replayed run does exactly
+//	what the recorded one did, events come up in the same order,
+//	and each device only has to check whether the next one is its
+//	own and is due now.  The last event is an EndOfLogEvent, written
+//	when Nachos halts or aborts; a log without one was cut short.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "eventlog.h"
+#include "system.h"
+
+static char *eventNames[] = { "console input", "network input", "random",
+			      "end of log" };
+
+//----------------------------------------------------------------------
+// EventLog::EventLog
+// 	Open a log, either to record events into or to replay them from.
+//
+//	"name" -- UNIX file holding the log
+//	"replay" -- if TRUE, replay the existing log; otherwise start
+//		a new one
+//----------------------------------------------------------------------
+
+EventLog::EventLog(char *name, bool replay)
+{
+    replaying = replay;
+    buffer = NULL;
+    buffered = 0;
+    ended = FALSE;
+    nextData = NULL;
+    if (replaying) {
+	fileno = OpenForReadWrite(name, TRUE);
+	ReadNext();
+    } else {
+	fileno = OpenForWrite(name);
+	buffer = new char[EventLogBufferSize];
+    }
+}
+
+//----------------------------------------------------------------------
+// EventLog::~EventLog
+// 	End the log, and close it.  A replay that stops before the log
+//	runs out did not repeat the recorded run, so say so.
+//----------------------------------------------------------------------
+
+EventLog::~EventLog()
+{
+    if (!replaying)
+	End();
+    else if (!IsUsedUp())
+	printf("Replay ended before the event log did (next event: %s, "
+	    "at time %d)\n", eventNames[nextType], nextWhen);
+    Close(fileno);
+    delete [] buffer;
+    delete [] nextData;
+}
+
+//----------------------------------------------------------------------
+// EventLog::Record
+// 	Add an event that happened at the current simulated time to
+//	the log.
+//
+//	"type" -- what kind of event it was
+//	"data" -- the input that arrived
+//	"size" -- how many bytes of it
+//----------------------------------------------------------------------
+
+void
+EventLog::Record(EventType type, char *data, int size)
+{
+    int header[3];
+
+    ASSERT(!replaying && !ended);
+    header[0] = stats->totalTicks;
+    header[1] = type;
+    header[2] = size;
+    if (buffered + (int) sizeof(header) + size > EventLogBufferSize)
+	Flush();
+    if ((int) sizeof(header) + size > EventLogBufferSize) {
+	WriteFile(fileno, (char *) header, sizeof(header));
+	WriteFile(fileno, data, size);
+	return;
+    }
+    bcopy((char *) header, buffer + buffered, sizeof(header));
+    buffered += sizeof(header);
+    bcopy(data, buffer + buffered, size);
+    buffered += size;
+}
+
+//----------------------------------------------------------------------
+// EventLog::End
+// 	When recording, add the end of the log, and write out everything
+//	still buffered.  Called when Nachos halts, and also when it
+//	aborts -- which is how a user program's Exit ends, for now -- so
+//	the log is complete either way.
+//----------------------------------------------------------------------
+
+void
+EventLog::End()
+{
+    if (replaying || ended)
+	return;
+    Record(EndOfLogEvent, NULL, 0);
+    ended = TRUE;
+    Flush();
+}
+
+//----------------------------------------------------------------------
+// EventLog::Replay
+// 	If the next event in the log is of the given type, and is due
+//	at the current simulated time, copy its data into "data", move
+//	on to the following event and return TRUE.  Otherwise return
+//	FALSE, and leave the event for later.
+//
+//	The replayed run has gone off the rails if an event is overdue;
+//	that happens if Nachos is started with different flags, or
+//	the kernel has changed, since the log was recorded.
+//----------------------------------------------------------------------
+
+bool
+EventLog::Replay(EventType type, char *data, int size)
+{
+    ASSERT(replaying);
+    if (nextType == -1)			// log used up
+	return FALSE;
+    if (nextWhen < stats->totalTicks) {
+	printf("Replay diverged: %s event logged at time %d missed, "
+	    "it is now %d\n", eventNames[nextType], nextWhen,
+	    stats->totalTicks);
+	fflush(stdout);
+	ASSERT(FALSE);
+    }
+    if ((nextType != type) || (nextWhen != stats->totalTicks))
+	return FALSE;
+
+    ASSERT(nextSize == size);
+    bcopy(nextData, data, size);
+    ReadNext();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// EventLog::ReadNext
+// 	Read the next event to be replayed from the log.  Past the end
+//	of the log, there is no next event.
+//----------------------------------------------------------------------
+
+void
+EventLog::ReadNext()
+{
+    int header[3];
+
+    delete [] nextData;
+    nextData = NULL;
+    if (ReadPartial(fileno, (char *) header, sizeof(header))
+						!= sizeof(header)) {
+	printf("Event log ends without an end of log: the recording was "
+	    "cut short\n");
+	nextType = -1;
+	return;
+    }
+    nextWhen = header[0];
+    nextType = header[1];
+    nextSize = header[2];
+    if (nextType == EndOfLogEvent) {
+	nextType = -1;
+	return;
+    }
+    nextData = new char[nextSize];
+    Read(fileno, nextData, nextSize);
+}
+
+//----------------------------------------------------------------------
+// EventLog::Flush
+// 	Write the buffered events out to the log.
+//----------------------------------------------------------------------
+
+void
+EventLog::Flush()
+{
+    if (buffered > 0)
+	WriteFile(fileno, buffer, buffered);
+    buffered = 0;
+}
+
+//----------------------------------------------------------------------
+// LoggedRandom
+// 	Return a pseudo-random number, as Random() does, but log it
+//	when recording, and take it from the log when replaying, so the
+//	replay does not depend on the seed or on the C library.
+//	A number drawn after the end of the log was not drawn in the
+//	recorded run, so the replay has diverged.
+//----------------------------------------------------------------------
+
+int
+LoggedRandom()
+{
+    int value;
+
+    if (eventLog == NULL)
+	return Random();
+    if (eventLog->IsReplaying()) {
+	if (eventLog->IsUsedUp()) {
+	    printf("Replay diverged: random number drawn at time %d, "
+		"after the end of the event log\n", stats->totalTicks);
+	    fflush(stdout);
+	    ASSERT(FALSE);
+	} else if (!eventLog->Replay(RandomEvent, (char *) &value, 
+							sizeof(int))) {
+	    printf("Replay diverged: random number drawn at time %d "
+		"was not logged\n", stats->totalTicks);
+	    fflush(stdout);
+	    ASSERT(FALSE);
+	}
+    } else {
+	value = Random();
+	eventLog->Record(RandomEvent, (char *) &value, sizeof(int));
+    }
+    return value;
+}
@@ -0,0 +1,76 @@
+// eventlog.h
+//	Data structures to record, and later replay, everything that
+//	makes one run of Nachos differ from the next.
+//
+//	Given the same inputs, the simulation is deterministic.  The
+//	inputs that are not under its control are characters typed at
+//	the console, packets arriving from other Nachos machines, and
+//	the pseudo-random numbers behind -rs and lost packets.  In record
+//	mode, each of these is logged, with the simulated time it
+//	arrived at; in replay mode the devices take them from the log
+//	instead, at exactly the same times, so the run is repeated
+//	tick for tick.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The kinds of event that get logged
+enum EventType { ConsoleInputEvent, NetworkInputEvent, RandomEvent,
+		 EndOfLogEvent };
+
+#define EventLogBufferSize	4096	// bytes of events buffered before
+					// being written out to the log
+
+// The following class defines the log, either being recorded or
+// being replayed.
+
+class EventLog {
+  public:
+    EventLog(char *name, bool replay);	// Open the UNIX file "name", to
+					// record a new log (replay FALSE)
+					// or to replay an old one
+    ~EventLog();			// End and close the log
+
+    bool IsReplaying() { return replaying; }
+    bool IsUsedUp() { return nextType == -1; }
+					// Has every event been replayed?
+    void End();				// Write out the end of the log, when
+					// recording; Nachos is done
+
+    void Record(EventType type, char *data, int size);
+					// Log that "size" bytes of "data"
+					// arrived now
+    bool Replay(EventType type, char *data, int size);
+    					// If the next logged event is of
+					// this type and is due now, copy it
+					// into "data" and return TRUE
+
+  private:
+    int fileno;				// UNIX file holding the log
+    bool replaying;			// are we replaying, or recording?
+
+    char *buffer;			// events not yet written to the log
+    int buffered;			// ... and how many bytes of them
+    bool ended;				// has End been called?
+
+    int nextWhen;			// the next event to replay, read
+    int nextType;			// ahead of time; nextType is -1
+    int nextSize;			// once the log is used up
+    char *nextData;
+
+    void ReadNext();			// Read in the next event to replay
+    void Flush();			// Write out the buffered events
+};
+
+extern int LoggedRandom();		// Random(), but recorded or
+					// replayed by the event log if
+					// there is one
+
+#endif // EVENTLOG_H
@@ -27,8 +27,9 @@
 // String definitions for debugging messages
 
 static char *intLevelNames[] = { "off", "on"};
-static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+char *intTypeNames[] = { "timer", "disk", "console write", 
+			"console read", "network send", "network recv",
+			"alarm"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -41,7 +42,7 @@ static char *intTypeNames[] = { "timer", "disk", "console write",
 //	"kind" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
 
-PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time, 
+PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, intptr_t param, int time, 
 				IntType kind)
 {
     handler = func;
@@ -178,6 +179,43 @@ Interrupt::OneTick()
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::NextTickIsQuiet
+// 	Return TRUE if a OneTick in user mode would only advance the
+//	clock, without any interrupt handler being called.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::NextTickIsQuiet()
+{
+    int when;
+
+    if (pending->SortedFront(&when) == NULL)
+	return TRUE;
+    return (when > stats->totalTicks + UserTick);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::QuietTick
+// 	Do what OneTick does in user mode, when NextTickIsQuiet.  Used
+//	by the machine simulation to run user instructions back to back
+//	(see Machine::ExecutePair and Machine::RunTranslated).
+//
+//	OneTick would take the first pending interrupt off the list,
+//	see that it is not due yet and put it back -- behind any others
+//	due at the same time.  We move it the same way, so that the
+//	interrupts still fire in exactly the same order.
+//----------------------------------------------------------------------
+
+void
+Interrupt::QuietTick()
+{
+    ASSERT((status == UserMode) && (level == IntOn));
+    stats->totalTicks += UserTick;
+    stats->userTicks += UserTick;
+    pending->SortedRequeueFirst();
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -241,10 +279,101 @@ void
 Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
+    if (reportThreadTimes && (currentThread != threadToBeDestroyed))
+	currentThread->PrintTimes();	// the others did as they finished
     stats->Print();
+#ifdef USER_PROGRAM
+    if (stats->keepInstrMix)
+	machine->PrintInstrMix();
+#endif
+    if (stats->keepDiskLatency)
+	stats->PrintDiskLatency();
     Cleanup();     // Never returns.
 }
 
+//----------------------------------------------------------------------
+// Interrupt::Checkpoint
+// 	Save the time and type of each pending interrupt, in the order
+//	they will fire, to the open UNIX file "fd".  The list is ended
+//	by an entry with type -1.
+//
+//	Handlers and their arguments are host addresses, which mean 
+//	nothing to another run of Nachos, so they are not saved; see 
+//	Restore.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Checkpoint(int fd)
+{
+    List *saved = new List();
+    PendingInterrupt *toSave;
+    int when, type;
+
+    while ((toSave = (PendingInterrupt *)pending->SortedRemove(&when)) 
+								!= NULL) {
+	type = toSave->type;
+	WriteFile(fd, (char *) &when, sizeof(int));
+	WriteFile(fd, (char *) &type, sizeof(int));
+	saved->SortedInsert(toSave, when);
+    }
+    when = 0;
+    type = -1;
+    WriteFile(fd, (char *) &when, sizeof(int));
+    WriteFile(fd, (char *) &type, sizeof(int));
+
+    delete pending;
+    pending = saved;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Restore
+// 	Replace the pending interrupts with the ones saved by Checkpoint.
+//
+//	Each device schedules its first interrupt when it is created,
+//	so for every interrupt type we borrow the handler and argument
+//	of whatever is pending now.  This means the restoring run has
+//	to create the same devices (e.g., the timer, with -rs) as the one
+//	that took the checkpoint, and that device requests still in
+//	flight (a disk transfer, say) cannot be restored -- nor can
+//	alarms, whose threads are not in the checkpoint anyway.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Restore(int fd)
+{
+    VoidFunctionPtr handlers[AlarmInt + 1];
+    intptr_t args[AlarmInt + 1];
+    PendingInterrupt *toRestore;
+    int when, type;
+
+    for (type = TimerInt; type <= AlarmInt; type++)
+	handlers[type] = NULL;
+    while ((toRestore = (PendingInterrupt *)pending->Remove()) != NULL) {
+	if (handlers[toRestore->type] == NULL) {
+	    handlers[toRestore->type] = toRestore->handler;
+	    args[toRestore->type] = toRestore->arg;
+	}
+	delete toRestore;
+    }
+
+    for (;;) {
+	Read(fd, (char *) &when, sizeof(int));
+	Read(fd, (char *) &type, sizeof(int));
+	if (type == -1)
+	    break;
+	ASSERT((type >= TimerInt) && (type <= AlarmInt));
+	if (handlers[type] == NULL) {
+	    printf("No %s device to restore a pending interrupt to.\n", 
+		intTypeNames[type]);
+	    fflush(stdout);
+	    ASSERT(FALSE);
+	}
+	toRestore = new PendingInterrupt(handlers[type], args[type], when,
+							(IntType) type);
+	pending->SortedInsert(toRestore, when);
+    }
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Schedule
 // 	Arrange for the CPU to be interrupted when simulated time
@@ -262,7 +391,8 @@ Interrupt::Halt()
 //	"type" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
 void
-Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
+Interrupt::Schedule(VoidFunctionPtr handler, intptr_t arg, int fromNow, 
+		    IntType type)
 {
     int when = stats->totalTicks + fromNow;
     PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
@@ -325,9 +455,13 @@ Interrupt::CheckIfDue(bool advanceClock)
     	machine->DelayedLoad(0, 0);
 #endif
     inHandler = TRUE;
-    status = SystemMode;			// whatever we were doing,
+    if (status != IdleMode)
+	status = SystemMode;			// whatever we were doing,
 						// we are now going to be
-						// running in the kernel
+						// running in the kernel --
+						// but the handler may want
+						// to know we were idle
+    TRACE(TraceInterrupt, toOccur->type);
     (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
     status = old;				// restore the machine status
     inHandler = FALSE;
@@ -342,7 +476,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 //----------------------------------------------------------------------
 
 static void
-PrintPending(int arg)
+PrintPending(intptr_t arg)
 {
     PendingInterrupt *pend = (PendingInterrupt *)arg;
 
@@ -48,9 +48,12 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network -- and the kernel's alarm clock
+// (see alarm.h), which unlike the time-slice timer keeps Nachos from
+// halting while it is pending.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				NetworkSendInt, NetworkRecvInt};
+				NetworkSendInt, NetworkRecvInt, AlarmInt};
+extern char *intTypeNames[];	// ... and their names
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -58,13 +61,14 @@ enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt,
 
 class PendingInterrupt {
   public:
-    PendingInterrupt(VoidFunctionPtr func, int param, int time, IntType kind);
+    PendingInterrupt(VoidFunctionPtr func, intptr_t param, int time,
+		     IntType kind);
 				// initialize an interrupt that will
 				// occur in the future
 
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
-    int arg;                    // The argument to the function.
+    intptr_t arg;               // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
 };
@@ -107,11 +111,19 @@ class Interrupt {
     // hardware device simulators.
 
     void Schedule(VoidFunctionPtr handler,// Schedule an interrupt to occur
-	int arg, int when, IntType type);// at time ``when''.  This is called
+	intptr_t arg, int when, IntType type);// at time ``when''.  This is called
     					// by the hardware device simulators.
     
     void OneTick();       		// Advance simulated time
 
+    bool NextTickIsQuiet();		// Would the next user-mode OneTick
+					// fire no interrupt?
+    void QuietTick();			// If so, it can be done this way
+					// instead, with much less work
+
+    void Checkpoint(int fd);		// Save/restore the pending interrupts
+    void Restore(int fd);		// to/from an open UNIX file
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
     List *pending;		// the list of interrupts scheduled
@@ -9,6 +9,7 @@
 
 #include "copyright.h"
 #include "machine.h"
+#include "blockcache.h"
 #include "system.h"
 
 // Textual names of the exceptions that can be generated by user program
@@ -72,6 +73,9 @@ Machine::Machine(bool debug)
 #endif
 
     singleStep = debug;
+    checkpointName = NULL;
+    fuseInstructions = TRUE;
+    blockCache = NULL;
     CheckEndian();
 }
 
@@ -85,6 +89,51 @@ Machine::~Machine()
     delete [] mainMemory;
     if (tlb != NULL)
         delete [] tlb;
+    delete blockCache;
+}
+
+//----------------------------------------------------------------------
+// Machine::CheckpointAt
+// 	Arrange for the state of the simulation to be saved to the UNIX
+//	file "name", at the first instruction boundary once simulated 
+//	time reaches "when".
+//----------------------------------------------------------------------
+
+void
+Machine::CheckpointAt(int when, char *name)
+{
+    checkpointTime = when;
+    checkpointName = name;
+}
+
+//----------------------------------------------------------------------
+// Machine::Checkpoint
+// 	Save the user-visible machine state -- registers, physical memory
+//	and the TLB, if any -- to the open UNIX file "fd".  The page
+//	table belongs to the address space, which saves it.
+//----------------------------------------------------------------------
+
+void
+Machine::Checkpoint(int fd)
+{
+    WriteFile(fd, (char *) registers, sizeof(registers));
+    WriteFile(fd, mainMemory, MemorySize);
+    if (tlb != NULL)
+	WriteFile(fd, (char *) tlb, TLBSize * sizeof(TranslationEntry));
+}
+
+//----------------------------------------------------------------------
+// Machine::Restore
+// 	Load the machine state saved by Checkpoint.
+//----------------------------------------------------------------------
+
+void
+Machine::Restore(int fd)
+{
+    Read(fd, (char *) registers, sizeof(registers));
+    Read(fd, mainMemory, MemorySize);
+    if (tlb != NULL)
+	Read(fd, (char *) tlb, TLBSize * sizeof(TranslationEntry));
 }
 
 //----------------------------------------------------------------------
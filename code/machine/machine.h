@@ -26,6 +26,8 @@
 #include "translate.h"
 #include "disk.h"
 
+class BlockCache;
+
 // Definitions related to the size, and format of user memory
 
 #define PageSize 	SectorSize 	// set the page size equal to
@@ -81,6 +83,9 @@ enum ExceptionType { NoException,           // Everything ok!
 class Instruction {
   public:
     void Decode();	// decode the binary representation of the instruction
+    bool FusesWith(Instruction *next);
+			// can this and "next", the instruction after it,
+			// be run together (see Machine::ExecutePair)?
 
     unsigned int value; // binary representation of the instruction
 
@@ -123,8 +128,19 @@ class Machine {
 
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
+    bool Execute(Instruction *instr);
+				// Execute one decoded instruction; FALSE
+				// if it raised an exception
+    bool RunTranslated();	// Run instructions from translated blocks,
+				// while nothing else needs doing
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
+    bool CanFusePair();		// May the next two instructions be run
+				// together?
+    bool ExecutePair(Instruction *first, Instruction *second);
+				// Execute a pair of decoded instructions
+				// in one step; FALSE if the first raised
+				// an exception
     
     bool ReadMem(int addr, int size, int* value);
     bool WriteMem(int addr, int size, int value);
@@ -146,6 +162,14 @@ class Machine {
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
+    void CheckpointAt(int when, char *name);
+				// Save a checkpoint to the UNIX file "name"
+				// once simulated time reaches "when"
+    void Checkpoint(int fd);	// Save/restore the CPU registers, physical
+    void Restore(int fd);	// memory and TLB to/from an open UNIX file
+    void PrintInstrMix();	// print the instruction mix kept with -ms
+    void WriteInstrMix(FILE *fp); // ... or write it as a JSON member
+
 
 // Data structures -- all of these are accessible to Nachos kernel code.
 // "public" for convenience.
@@ -182,11 +206,18 @@ class Machine {
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
 
+    bool fuseInstructions;	// run common instruction pairs in one step
+				// (see ExecutePair); on unless -nf
+    BlockCache *blockCache;	// translated user code (see RunTranslated),
+				// NULL unless -j
+
   private:
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
+    char *checkpointName;	// where to save a checkpoint, NULL if none
+    int checkpointTime;		// ... and when
 };
 
 extern void ExceptionHandler(ExceptionType which);
@@ -194,6 +225,11 @@ extern void ExceptionHandler(ExceptionType which);
 				// user system calls and exceptions
 				// Defined in exception.cc
 
+extern void TakeCheckpoint(char *name);
+				// Save the state of the simulation, between
+				// two user instructions.  Defined in 
+				// checkpoint.cc
+
 
 // Routines for converting Words and Short Words to and from the
 // simulated machine's format of little endian.  If the host machine
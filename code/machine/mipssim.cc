@@ -14,9 +14,11 @@
 
 #include "machine.h"
 #include "mipssim.h"
+#include "blockcache.h"
 #include "system.h"
 
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
+static bool IsPairHead(int opCode);
 
 //----------------------------------------------------------------------
 // Machine::Run
@@ -37,14 +39,85 @@ Machine::Run()
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
     for (;;) {
-        OneInstruction(instr);
+	if ((blockCache == NULL) || !RunTranslated())
+	    OneInstruction(instr);
 	interrupt->OneTick();
 	if (singleStep && (runUntilTime <= stats->totalTicks))
 	  Debugger();
+	if (checkpointName != NULL && (checkpointTime <= stats->totalTicks)) {
+	    TakeCheckpoint(checkpointName);
+	    checkpointName = NULL;		// only once
+	}
     }
 }
 
 
+//----------------------------------------------------------------------
+// Machine::RunTranslated
+// 	Run user instructions from translated blocks (see blockcache.h),
+//	for as long as nothing needs to happen between two of them.
+//
+//	Each instruction is executed just as OneInstruction would --
+//	common pairs of them together, by ExecutePair, from the pairing
+//	found when the block was translated -- and takes its tick just as
+//	under Run: we go on to the next one only
+//	if that tick fires no interrupt, and no checkpoint is due then.
+//	The tick after the last instruction is left for Run to do
+//	through OneTick.
+//
+//	Returns FALSE if no instruction could be run this way -- the
+//	debugger or the 'm' and 'i' debug messages want to see each
+//	instruction, or fetching the next one raises an exception.  Run
+//	must then interpret that instruction as usual.
+//----------------------------------------------------------------------
+
+bool
+Machine::RunTranslated()
+{
+    TranslatedBlock *block;
+    Instruction *instr, *second = NULL;
+    int i, step, physAddr, startAddr;
+
+    if (singleStep || DebugIsEnabled('m') || DebugIsEnabled('i'))
+	return FALSE;
+    if (Translate(registers[PCReg], &physAddr, 4, FALSE) != NoException)
+	return FALSE;
+    block = blockCache->Find(physAddr);
+    startAddr = registers[PCReg];
+    i = 0;
+
+    for (;;) {
+	instr = blockCache->Fetch(block, physAddr, i);
+	step = 1;
+	if (fuseInstructions && block->fused[i] && CanFusePair()) {
+	    second = blockCache->Fetch(block, physAddr + 4, i + 1);
+	    if (block->fused[i])	// unless "second" has just changed
+		step = 2;
+	}
+	if (!((step == 2) ? ExecutePair(instr, second) : Execute(instr)))
+	    return TRUE;		// the kernel handled an exception
+	if (!interrupt->NextTickIsQuiet() || ((checkpointName != NULL) &&
+		    (checkpointTime <= stats->totalTicks + UserTick)))
+	    return TRUE;
+
+	// Find the next instruction: it follows in the same block,
+	// unless we have branched, or reached the end of the page.
+	if ((registers[PCReg] == startAddr + (i + step) * 4) &&
+						(i + step < block->length)) {
+	    i += step;
+	    physAddr += step * 4;
+	} else {
+	    if (Translate(registers[PCReg], &physAddr, 4, FALSE)
+							!= NoException)
+		return TRUE;
+	    block = blockCache->Find(physAddr);
+	    startAddr = registers[PCReg];
+	    i = 0;
+	}
+	interrupt->QuietTick();		// the tick Run would have done
+    }
+}
+
 //----------------------------------------------------------------------
 // TypeToReg
 // 	Retrieve the register # referred to in an instruction. 
@@ -67,6 +140,99 @@ TypeToReg(RegType reg, Instruction *instr)
     }
 }
 
+//----------------------------------------------------------------------
+// ReadsRegister
+// 	Return TRUE if the instruction uses register "reg" as a source
+//	operand.  Used to spot an instruction sitting in the delay slot
+//	of a load that targets one of its operands.
+//----------------------------------------------------------------------
+
+static bool
+ReadsRegister(Instruction *instr, int reg)
+{
+    switch (instr->opCode) {
+      case OP_J:
+      case OP_JAL:
+      case OP_LUI:
+      case OP_MFHI:
+      case OP_MFLO:
+      case OP_SYSCALL:
+      case OP_RES:
+      case OP_UNIMP:
+	return FALSE;
+
+      case OP_ADDI:		// I-format: rt is the destination
+      case OP_ADDIU:
+      case OP_ANDI:
+      case OP_ORI:
+      case OP_XORI:
+      case OP_SLTI:
+      case OP_SLTIU:
+      case OP_LB:
+      case OP_LBU:
+      case OP_LH:
+      case OP_LHU:
+      case OP_LW:
+      case OP_BGEZ:		// rt selects the branch condition
+      case OP_BGEZAL:
+      case OP_BGTZ:
+      case OP_BLEZ:
+      case OP_BLTZ:
+      case OP_BLTZAL:
+      case OP_JR:
+      case OP_JALR:
+      case OP_MTHI:
+      case OP_MTLO:
+	return (instr->rs == reg);
+
+      default:			// R-format ALU ops, BEQ/BNE, stores, 
+				// and LWL/LWR, which merge into rt
+	return (instr->rs == reg) || (instr->rt == reg);
+    }
+}
+
+//----------------------------------------------------------------------
+// CountInstruction
+// 	Update the instruction mix for an instruction that has just
+//	executed successfully (only called when -ms was given).
+//
+//	"loadReg" is the register the previous instruction is loading
+//		(0 if none), which is not written until after this one.
+//	"taken" is TRUE if the instruction is a branch whose condition
+//		held.  (Comparing the new PC with the fall-through address
+//		won't do: a branch to the instruction after its delay slot
+//		is taken, but ends up there anyway.)
+//----------------------------------------------------------------------
+
+static void
+CountInstruction(Instruction *instr, int loadReg, bool taken)
+{
+    stats->numOpExecuted[instr->opCode]++;
+    if (loadReg != 0 && ReadsRegister(instr, loadReg))
+	stats->numLoadStalls++;
+
+    switch (instr->opCode) {
+      case OP_BEQ:
+      case OP_BNE:
+      case OP_BGEZ:
+      case OP_BGEZAL:
+      case OP_BGTZ:
+      case OP_BLEZ:
+      case OP_BLTZ:
+      case OP_BLTZAL:
+	if (taken)
+	    stats->numBranchesTaken++;
+	else
+	    stats->numBranchesNotTaken++;
+	break;
+
+      case OP_LWL:
+      case OP_LWR:
+	stats->numUnalignedLoads++;
+	break;
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::OneInstruction
 // 	Execute one instruction from a user-level program
@@ -79,6 +245,10 @@ TypeToReg(RegType reg, Instruction *instr)
 // 	the OS software must increment the PC so execution begins
 // 	at the instruction immediately after the syscall. 
 //
+//	An instruction that starts a common pair (see
+//	Instruction::FusesWith) is run together with the one after it, by
+//	ExecutePair, when nothing needs to happen in between.
+//
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
 //	We get re-entrancy by never caching any data -- we always re-start the
@@ -93,10 +263,8 @@ TypeToReg(RegType reg, Instruction *instr)
 void
 Machine::OneInstruction(Instruction *instr)
 {
-    int raw;
-    int nextLoadReg = 0; 	
-    int nextLoadValue = 0; 	// record delayed load operation, to apply
-				// in the future
+    Instruction second;
+    int raw, physAddr;
 
     // Fetch instruction 
     if (!machine->ReadMem(registers[PCReg], 4, &raw))
@@ -113,9 +281,43 @@ Machine::OneInstruction(Instruction *instr)
 		TypeToReg(str->args[1], instr), TypeToReg(str->args[2], instr));
        printf("\n");
        }
-    
+
+    // If it starts a pair, and the second half is on the same page
+    // (so translating it can't fault), run the two together.
+    if (fuseInstructions && IsPairHead(instr->opCode) && !singleStep && 
+		!DebugIsEnabled('m') && !DebugIsEnabled('i') && CanFusePair()
+		&& ((registers[PCReg] % PageSize) != PageSize - 4)
+		&& (Translate(registers[NextPCReg], &physAddr, 4, FALSE) 
+							== NoException)) {
+	second.value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+	second.Decode();
+	if (instr->FusesWith(&second)) {
+	    (void) ExecutePair(instr, &second);
+	    return;
+	}
+    }
+    (void) Execute(instr);
+}
+
+//----------------------------------------------------------------------
+// Machine::Execute
+// 	Execute one decoded user instruction, the one at registers[PCReg],
+//	and advance the program counters past it.
+//
+//	Returns FALSE if the instruction raised an exception instead
+//	(the kernel has then already handled it).
+//----------------------------------------------------------------------
+
+bool
+Machine::Execute(Instruction *instr)
+{
+    int nextLoadReg = 0; 	
+    int nextLoadValue = 0; 	// record delayed load operation, to apply
+				// in the future
+
     // Compute next pc, but don't install in case there's an error or branch.
     int pcAfter = registers[NextPCReg] + 4;
+    bool taken = FALSE;		// for the instruction mix: a branch was taken
     int sum, diff, tmp, value;
     unsigned int rs, rt, imm;
 
@@ -127,7 +329,7 @@ Machine::OneInstruction(Instruction *instr)
 	if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
 	    ((registers[instr->rs] ^ sum) & SIGN_BIT)) {
 	    RaiseException(OverflowException, 0);
-	    return;
+	    return FALSE;
 	}
 	registers[instr->rd] = sum;
 	break;
@@ -137,7 +339,7 @@ Machine::OneInstruction(Instruction *instr)
 	if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT) &&
 	    ((instr->extra ^ sum) & SIGN_BIT)) {
 	    RaiseException(OverflowException, 0);
-	    return;
+	    return FALSE;
 	}
 	registers[instr->rt] = sum;
 	break;
@@ -159,36 +361,42 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_BEQ:
-	if (registers[instr->rs] == registers[instr->rt])
+	taken = (registers[instr->rs] == registers[instr->rt]);
+	if (taken)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
 	break;
 	
       case OP_BGEZAL:
 	registers[R31] = registers[NextPCReg] + 4;
       case OP_BGEZ:
-	if (!(registers[instr->rs] & SIGN_BIT))
+	taken = !(registers[instr->rs] & SIGN_BIT);
+	if (taken)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
 	break;
 	
       case OP_BGTZ:
-	if (registers[instr->rs] > 0)
+	taken = (registers[instr->rs] > 0);
+	if (taken)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
 	break;
 	
       case OP_BLEZ:
-	if (registers[instr->rs] <= 0)
+	taken = (registers[instr->rs] <= 0);
+	if (taken)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
 	break;
 	
       case OP_BLTZAL:
 	registers[R31] = registers[NextPCReg] + 4;
       case OP_BLTZ:
-	if (registers[instr->rs] & SIGN_BIT)
+	taken = ((registers[instr->rs] & SIGN_BIT) != 0);
+	if (taken)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
 	break;
 	
       case OP_BNE:
-	if (registers[instr->rs] != registers[instr->rt])
+	taken = (registers[instr->rs] != registers[instr->rt]);
+	if (taken)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
 	break;
 	
@@ -232,7 +440,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_LBU:
 	tmp = registers[instr->rs] + instr->extra;
 	if (!machine->ReadMem(tmp, 1, &value))
-	    return;
+	    return FALSE;
 
 	if ((value & 0x80) && (instr->opCode == OP_LB))
 	    value |= 0xffffff00;
@@ -247,10 +455,10 @@ Machine::OneInstruction(Instruction *instr)
 	tmp = registers[instr->rs] + instr->extra;
 	if (tmp & 0x1) {
 	    RaiseException(AddressErrorException, tmp);
-	    return;
+	    return FALSE;
 	}
 	if (!machine->ReadMem(tmp, 2, &value))
-	    return;
+	    return FALSE;
 
 	if ((value & 0x8000) && (instr->opCode == OP_LH))
 	    value |= 0xffff0000;
@@ -269,10 +477,10 @@ Machine::OneInstruction(Instruction *instr)
 	tmp = registers[instr->rs] + instr->extra;
 	if (tmp & 0x3) {
 	    RaiseException(AddressErrorException, tmp);
-	    return;
+	    return FALSE;
 	}
 	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
+	    return FALSE;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
 	break;
@@ -286,7 +494,7 @@ Machine::OneInstruction(Instruction *instr)
 	ASSERT((tmp & 0x3) == 0);  
 
 	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
+	    return FALSE;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
 	else
@@ -317,7 +525,7 @@ Machine::OneInstruction(Instruction *instr)
 	ASSERT((tmp & 0x3) == 0);  
 
 	if (!machine->ReadMem(tmp, 4, &value))
-	    return;
+	    return FALSE;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
 	else
@@ -383,13 +591,13 @@ Machine::OneInstruction(Instruction *instr)
       case OP_SB:
 	if (!machine->WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
-	    return;
+	    return FALSE;
 	break;
 	
       case OP_SH:
 	if (!machine->WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
-	    return;
+	    return FALSE;
 	break;
 	
       case OP_SLL:
@@ -459,7 +667,7 @@ Machine::OneInstruction(Instruction *instr)
 	if (((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
 	    ((registers[instr->rs] ^ diff) & SIGN_BIT)) {
 	    RaiseException(OverflowException, 0);
-	    return;
+	    return FALSE;
 	}
 	registers[instr->rd] = diff;
 	break;
@@ -471,7 +679,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_SW:
 	if (!machine->WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
-	    return;
+	    return FALSE;
 	break;
 	
       case OP_SWL:	  
@@ -482,7 +690,7 @@ Machine::OneInstruction(Instruction *instr)
 	ASSERT((tmp & 0x3) == 0);  
 
 	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-	    return;
+	    return FALSE;
 	switch (tmp & 0x3) {
 	  case 0:
 	    value = registers[instr->rt];
@@ -501,7 +709,7 @@ Machine::OneInstruction(Instruction *instr)
 	    break;
 	}
 	if (!machine->WriteMem((tmp & ~0x3), 4, value))
-	    return;
+	    return FALSE;
 	break;
     	
       case OP_SWR:	  
@@ -512,7 +720,7 @@ Machine::OneInstruction(Instruction *instr)
 	ASSERT((tmp & 0x3) == 0);  
 
 	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
-	    return;
+	    return FALSE;
 	switch (tmp & 0x3) {
 	  case 0:
 	    value = (value & 0xffffff) | (registers[instr->rt] << 24);
@@ -528,12 +736,12 @@ Machine::OneInstruction(Instruction *instr)
 	    break;
 	}
 	if (!machine->WriteMem((tmp & ~0x3), 4, value))
-	    return;
+	    return FALSE;
 	break;
     	
       case OP_SYSCALL:
 	RaiseException(SyscallException, 0);
-	return; 
+	return FALSE; 
 	
       case OP_XOR:
 	registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
@@ -546,13 +754,19 @@ Machine::OneInstruction(Instruction *instr)
       case OP_RES:
       case OP_UNIMP:
 	RaiseException(IllegalInstrException, 0);
-	return;
+	return FALSE;
 	
       default:
 	ASSERT(FALSE);
     }
     
     // Now we have successfully executed the instruction.
+
+    // Keep the instruction mix, if asked to.  This must happen before
+    // the delayed load below, while LoadReg still names the register
+    // the previous instruction is loading.
+    if (stats->keepInstrMix)
+	CountInstruction(instr, registers[LoadReg], taken);
     
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
@@ -562,6 +776,223 @@ Machine::OneInstruction(Instruction *instr)
 						// are jumping into lala-land
     registers[PCReg] = registers[NextPCReg];
     registers[NextPCReg] = pcAfter;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// IsPairHead
+// 	Return TRUE if an instruction with this opcode can be the first
+//	of a pair run by Machine::ExecutePair.
+//----------------------------------------------------------------------
+
+static bool
+IsPairHead(int opCode)
+{
+    switch (opCode) {
+      case OP_LUI:
+      case OP_LW:
+      case OP_SLT:
+      case OP_SLTU:
+      case OP_SLTI:
+      case OP_SLTIU:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Instruction::FusesWith
+// 	Return TRUE if this instruction and "next", the one after it,
+//	form one of the pairs that compiled code is full of, and that
+//	Machine::ExecutePair runs in one step:
+//
+//		LUI r; ORI/ADDIU x,r,imm	(a 32-bit constant or address)
+//		LW r; ADDU/SUBU/ADDIU/SLL/AND/ANDI/XOR/SLT/SLTU
+//					(the load delay slot; mostly a NOP)
+//		SLT/SLTU/SLTI/SLTIU r; BEQ/BNE on r	(compare and branch)
+//----------------------------------------------------------------------
+
+bool
+Instruction::FusesWith(Instruction *next)
+{
+    int dest;
+
+    if (!IsPairHead(opCode))
+	return FALSE;
+    switch (opCode) {
+      case OP_LUI:
+	return ((next->opCode == OP_ORI) || (next->opCode == OP_ADDIU))
+					&& (next->rs == rt);
+
+      case OP_LW:
+	switch (next->opCode) {
+	  case OP_ADDU: case OP_SUBU: case OP_ADDIU: case OP_SLL:
+	  case OP_AND: case OP_ANDI: case OP_XOR: case OP_SLT: case OP_SLTU:
+	    return TRUE;
+	  default:
+	    return FALSE;
+	}
+
+      default:				// SLT, SLTU, SLTI, SLTIU
+	dest = ((opCode == OP_SLT) || (opCode == OP_SLTU)) ? rd : rt;
+	return ((next->opCode == OP_BEQ) || (next->opCode == OP_BNE))
+			&& ((next->rs == dest) || (next->rt == dest));
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::CanFusePair
+// 	Return TRUE if the instruction at registers[PCReg] may be run
+//	together with the one after it by ExecutePair.
+//
+//	The outcome must be exactly that of running them one at a time,
+//	and time advances by one tick in between.  So the tick must fire
+//	no interrupt, and no checkpoint may be due then.  And the second
+//	instruction must be the next word: the first must not be in the
+//	delay slot of a branch.
+//
+//	The caller checks that nobody -- the debugger, or the 'm' and
+//	'i' debug messages -- wants to see each instruction.
+//----------------------------------------------------------------------
+
+bool
+Machine::CanFusePair()
+{
+    if ((checkpointName != NULL) && 
+		(checkpointTime <= stats->totalTicks + UserTick))
+	return FALSE;
+    return (registers[NextPCReg] == registers[PCReg] + 4)
+			&& interrupt->NextTickIsQuiet();
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecutePair
+// 	Execute two decoded user instructions that form a pair (see
+//	Instruction::FusesWith), the one at registers[PCReg] and the one
+//	after it, in one step, taking the tick between them.  The caller
+//	has checked CanFusePair.
+//
+//	This does what two Execute calls would, but with only the cases
+//	of the pairs to go through: the second instruction still sees
+//	the load before it as pending, and a branch still has its delay
+//	slot.  Only the first instruction can raise an exception (an LW);
+//	we then return FALSE, without having run the second.
+//----------------------------------------------------------------------
+
+bool
+Machine::ExecutePair(Instruction *first, Instruction *second)
+{
+    int loadReg = registers[LoadReg];	// for the instruction mix
+    int pcAfter, tmp, value;
+    bool equal, taken = FALSE;
+
+    // The first instruction: a constant, a load or a comparison
+    switch (first->opCode) {
+      case OP_LUI:
+	registers[first->rt] = first->extra << 16;
+	DelayedLoad(0, 0);
+	break;
+
+      case OP_LW:
+	tmp = registers[first->rs] + first->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    return FALSE;
+	}
+	if (!ReadMem(tmp, 4, &value))
+	    return FALSE;
+	DelayedLoad(first->rt, value);	// lands after the second
+	break;
+
+      case OP_SLT:
+	registers[first->rd] = (registers[first->rs] < registers[first->rt]);
+	DelayedLoad(0, 0);
+	break;
+
+      case OP_SLTU:
+	registers[first->rd] = ((unsigned int) registers[first->rs] <
+					(unsigned int) registers[first->rt]);
+	DelayedLoad(0, 0);
+	break;
+
+      case OP_SLTI:
+	registers[first->rt] = (registers[first->rs] < first->extra);
+	DelayedLoad(0, 0);
+	break;
+
+      case OP_SLTIU:
+	registers[first->rt] = ((unsigned int) registers[first->rs] <
+					(unsigned int) first->extra);
+	DelayedLoad(0, 0);
+	break;
+
+      default:
+	ASSERT(FALSE);
+    }
+    if (stats->keepInstrMix)
+	CountInstruction(first, loadReg, FALSE);
+    registers[PrevPCReg] = registers[PCReg];
+    registers[PCReg] = registers[NextPCReg];
+    registers[NextPCReg] += 4;
+    interrupt->QuietTick();		// the tick Run would have done
+    stats->numFusedPairs++;
+
+    // The second instruction: an ALU operation or a branch
+    loadReg = registers[LoadReg];
+    pcAfter = registers[NextPCReg] + 4;
+    switch (second->opCode) {
+      case OP_ORI:
+	registers[second->rt] = registers[second->rs] | 
+						(second->extra & 0xffff);
+	break;
+      case OP_ADDIU:
+	registers[second->rt] = registers[second->rs] + second->extra;
+	break;
+      case OP_ANDI:
+	registers[second->rt] = registers[second->rs] & 
+						(second->extra & 0xffff);
+	break;
+      case OP_ADDU:
+	registers[second->rd] = registers[second->rs] + registers[second->rt];
+	break;
+      case OP_SUBU:
+	registers[second->rd] = registers[second->rs] - registers[second->rt];
+	break;
+      case OP_AND:
+	registers[second->rd] = registers[second->rs] & registers[second->rt];
+	break;
+      case OP_XOR:
+	registers[second->rd] = registers[second->rs] ^ registers[second->rt];
+	break;
+      case OP_SLL:
+	registers[second->rd] = registers[second->rt] << second->extra;
+	break;
+      case OP_SLT:
+	registers[second->rd] = 
+			(registers[second->rs] < registers[second->rt]);
+	break;
+      case OP_SLTU:
+	registers[second->rd] = ((unsigned int) registers[second->rs] <
+					(unsigned int) registers[second->rt]);
+	break;
+      case OP_BEQ:
+      case OP_BNE:
+	equal = (registers[second->rs] == registers[second->rt]);
+	taken = (second->opCode == OP_BEQ) ? equal : !equal;
+	if (taken)
+	    pcAfter = registers[NextPCReg] + IndexToAddr(second->extra);
+	break;
+      default:
+	ASSERT(FALSE);
+    }
+    if (stats->keepInstrMix)
+	CountInstruction(second, loadReg, taken);
+    DelayedLoad(0, 0);
+    registers[PrevPCReg] = registers[PCReg];
+    registers[PCReg] = registers[NextPCReg];
+    registers[NextPCReg] = pcAfter;
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -581,6 +1012,76 @@ Machine::DelayedLoad(int nextReg, int nextValue)
     registers[0] = 0; 	// and always make sure R0 stays zero.
 }
 
+//----------------------------------------------------------------------
+// Machine::PrintInstrMix
+// 	Print how often each opcode was executed, most frequent first,
+//	along with branch, load-delay and unaligned load counts.  
+//
+//	Every instruction costs UserTick; "cycles" charges one more for
+//	each load whose result was needed in its delay slot, which is
+//	what an R3000 without the compiler's help would stall for.
+//----------------------------------------------------------------------
+
+void
+Machine::PrintInstrMix()
+{
+    int order[NumOpCodes];
+    int i, j, op, total = 0;
+
+    // Sort the opcodes by decreasing count (insertion sort; there are
+    // only 64 of them).
+    for (i = 0; i < NumOpCodes; i++) {
+	total += stats->numOpExecuted[i];
+	op = i;
+	for (j = i; j > 0 && stats->numOpExecuted[order[j - 1]] <
+					stats->numOpExecuted[op]; j--)
+	    order[j] = order[j - 1];
+	order[j] = op;
+    }
+
+    printf("Instruction mix: %d instructions, %d cycles\n", total, 
+	total * UserTick + stats->numLoadStalls);
+    for (i = 0; i < NumOpCodes; i++) {
+	op = order[i];
+	if (stats->numOpExecuted[op] == 0)
+	    break;
+
+	// opStrings holds the disassembly format; print just the mnemonic.
+	char *name = opStrings[op].string;
+	printf("    %-8.*s %10d  %5.1f%%\n", (int) strcspn(name, " "), name,
+	    stats->numOpExecuted[op], 
+	    100.0 * stats->numOpExecuted[op] / total);
+    }
+    printf("Branches: taken %d, not taken %d\n", stats->numBranchesTaken,
+	stats->numBranchesNotTaken);
+    printf("Load delay stalls %d, unaligned loads (LWL/LWR) %d\n",
+	stats->numLoadStalls, stats->numUnalignedLoads);
+    printf("Instruction pairs fused %d\n", stats->numFusedPairs);
+}
+
+//----------------------------------------------------------------------
+// Machine::WriteInstrMix
+// 	Write how often each opcode was executed to "fp", as an "opcodes"
+//	member of a JSON object, keyed by mnemonic, in opcode order.
+//----------------------------------------------------------------------
+
+void
+Machine::WriteInstrMix(FILE *fp)
+{
+    bool first = TRUE;
+
+    fprintf(fp, "  \"opcodes\": {");
+    for (int op = 0; op < NumOpCodes; op++) {
+	if (stats->numOpExecuted[op] == 0)
+	    continue;
+	char *name = opStrings[op].string;
+	fprintf(fp, "%s\"%.*s\": %d", first ? "" : ", ",
+	    (int) strcspn(name, " "), name, stats->numOpExecuted[op]);
+	first = FALSE;
+    }
+    fprintf(fp, "}");
+}
+
 //----------------------------------------------------------------------
 // Instruction::Decode
 // 	Decode a MIPS instruction 
@@ -11,69 +11,117 @@
 #include "copyright.h"
 #include "system.h"
 
+// A packet on its way out: waiting in the transmit queue, being sent,
+// or crossing the link.  It is padded out to MaxWireSize.
+class OutPacket {
+  public:
+    Network *net;		// the device sending it
+    int size;			// bytes that go over the wire
+    bool lost;			// whether the network will drop it
+    char buffer[MaxWireSize];	// packet header and data
+};
+
 // Dummy functions because C++ can't call member functions indirectly 
-static void NetworkReadPoll(int arg)
+static void NetworkReadPoll(intptr_t arg)
 { Network *net = (Network *)arg; net->CheckPktAvail(); }
-static void NetworkSendDone(int arg)
+static void NetworkSendDone(intptr_t arg)
 { Network *net = (Network *)arg; net->SendDone(); }
+static void NetworkWriteDone(intptr_t arg)
+{ Network *net = (Network *)arg; net->WriteDone(); }
+static void NetworkArrival(intptr_t arg)
+{ OutPacket *packet = (OutPacket *)arg; packet->net->PacketArrives(packet); }
 
 // Initialize the network emulation
 //   addr is used to generate the socket name
 //   reliability says whether we drop packets to emulate unreliable links
 //   readAvail, writeDone, callArg -- analogous to console
+//   linkModel, if not NULL, says how fast and how far the other 
+//	machines are
 Network::Network(NetworkAddress addr, double reliability,
-	VoidFunctionPtr readAvail, VoidFunctionPtr writeDone, int callArg)
+	VoidFunctionPtr readAvail, VoidFunctionPtr writeDone, intptr_t callArg,
+	LinkModel *linkModel)
 {
     ident = addr;
-    if (reliability < 0) chanceToWork = 0;
-    else if (reliability > 1) chanceToWork = 1;
-    else chanceToWork = reliability;
+    SetReliability(reliability);
+
+    if (linkModel != NULL)
+	link = *linkModel;
+    ASSERT((link.bandwidth >= 0) && (link.latency >= 0) 
+		&& (link.jitter >= 0) && (link.queueSize > 0));
+    sendTime = SendTime(MaxWireSize);
 
     // set up the stuff to emulate asynchronous interrupts
     writeHandler = writeDone;
     readHandler = readAvail;
     handlerArg = callArg;
-    sendBusy = FALSE;
+    sending = NULL;
+    sendQueue = new List;
+    queued = 0;
+    writeWaiting = FALSE;
+    lastArrival = 0;
     inHdr.length = 0;
+    recvBatch = new char[RecvBatchSize * MaxWireSize];
+    recvNext = recvCount = 0;
     
     sock = OpenSocket();
     sprintf(sockName, "SOCKET_%d", (int)addr);
     AssignNameToSocket(sockName, sock);		 // Bind socket to a filename 
 						 // in the current directory.
 
-    // start polling for incoming packets
-    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
+    // start polling for incoming packets, as often as a full packet 
+    // could come in
+    interrupt->Schedule(NetworkReadPoll, (intptr_t) this, sendTime, NetworkRecvInt);
 }
 
 Network::~Network()
 {
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
+    delete [] recvBatch;
+    delete sendQueue;
 }
 
 // if a packet is already buffered, we simply delay reading 
 // the incoming packet.  In real life, the incoming 
 // packet might be dropped if we can't read it in time.
+//
+// Packets are delivered one per poll, sendTime apart, as they would
+// come off the wire.  But under a burst, polling the socket (and
+// reading it) for each of them would cost two UNIX system calls a
+// packet; so when we run out, we read every packet waiting at once,
+// and only go back to the socket once they have all been delivered.
 void
 Network::CheckPktAvail()
 {
+    char *buffer;
+
     // schedule the next time to poll for a packet
-    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
+    interrupt->Schedule(NetworkReadPoll, (intptr_t) this, sendTime, NetworkRecvInt);
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
 
-    // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+    // otherwise, read packet in -- from the event log, if replaying
+    if ((eventLog != NULL) && eventLog->IsReplaying()) {
+	buffer = recvBatch;
+	if (!eventLog->Replay(NetworkInputEvent, buffer, MaxWireSize))
+	    return;
+    } else {
+	if (recvCount == 0)	// nothing left from the last read
+	    FillRecvBatch();
+	if (recvCount == 0)	// do nothing if no packet to be read
+	    return;
+	buffer = recvBatch + recvNext * MaxWireSize;
+	recvNext++;
+	recvCount--;
+	if (eventLog != NULL)
+	    eventLog->Record(NetworkInputEvent, buffer, MaxWireSize);
+    }
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
     ASSERT((inHdr.to == ident) && (inHdr.length <= MaxPacketSize));
     bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
-    delete []buffer ;
 
     DEBUG('n', "Network received packet from %d, length %d...\n",
 	  				(int) inHdr.from, inHdr.length);
@@ -83,44 +131,135 @@ Network::CheckPktAvail()
     (*readHandler)(handlerArg);	
 }
 
-// notify user that another packet can be sent
+// read all the packets waiting in the socket, as many as fit
+void
+Network::FillRecvBatch()
+{
+    recvNext = 0;
+    recvCount = 0;
+    if (!PollSocket(sock))	// nothing there
+	return;
+    recvCount = ReadManyFromSocket(sock, recvBatch, MaxWireSize,
+							RecvBatchSize);
+    DEBUG('n', "Network read %d packets at once\n", recvCount);
+}
+
+// change the chance that a packet sent from now on gets through
+void
+Network::SetReliability(double reliability)
+{
+    if (reliability < 0) chanceToWork = 0;
+    else if (reliability > 1) chanceToWork = 1;
+    else chanceToWork = reliability;
+}
+
+// how long it takes to put "size" bytes on the wire
+int
+Network::SendTime(int size)
+{
+    if (link.bandwidth == 0)
+	return NetworkTime;
+    return max(divRoundUp(size * 1000, link.bandwidth), 1);
+}
+
+// start sending the packet at the head of the queue
+void
+Network::StartSending()
+{
+    sending = (OutPacket *)sendQueue->Remove();
+    interrupt->Schedule(NetworkSendDone, (intptr_t) this, 
+			SendTime(sending->size), NetworkSendInt);
+}
+
+// the packet being sent is on the wire: send it on its way, start on the
+// next one, and notify user if there is now room for another packet
 void
 Network::SendDone()
 {
-    sendBusy = FALSE;
+    OutPacket *packet = sending;
+    int arrival;
+
+    sending = NULL;
+    queued--;
     stats->numPacketsSent++;
+
+    if (packet->lost)
+	delete packet;
+    else if ((link.latency == 0) && (link.jitter == 0))
+	PacketArrives(packet);
+    else {
+	arrival = stats->totalTicks + link.latency;
+	if (link.jitter > 0)
+	    arrival += LoggedRandom() % (link.jitter + 1);
+	arrival = max(arrival, lastArrival);	// no overtaking
+	lastArrival = arrival;
+	if (arrival == stats->totalTicks)
+	    PacketArrives(packet);
+	else
+	    interrupt->Schedule(NetworkArrival, (intptr_t) packet,
+			arrival - stats->totalTicks, NetworkSendInt);
+    }
+
+    if (queued > 0)
+	StartSending();
+    if (writeWaiting) {
+	writeWaiting = FALSE;
+	(*writeHandler)(handlerArg);
+    }
+}
+
+// notify user that another packet can be sent
+void
+Network::WriteDone()
+{
     (*writeHandler)(handlerArg);
 }
 
-// send a packet by concatenating hdr and data, and schedule
-// an interrupt to tell the user when the next packet can be sent 
+// the packet has crossed the link: hand it to the machine it is for
+void
+Network::PacketArrives(OutPacket *packet)
+{
+    char toName[32];
+
+    sprintf(toName, "SOCKET_%d", (int)((PacketHeader *)packet->buffer)->to);
+    SendToSocket(sock, packet->buffer, MaxWireSize, toName);
+    delete packet;
+}
+
+// queue a packet to be sent, after the ones already waiting, and
+// schedule an interrupt to tell the user when the next packet can be 
+// sent -- right away, if there is room in the queue
 //
 // Note we always pad out a packet to MaxWireSize before putting it into
-// the socket, because it's simpler at the receive end.
+// the socket, because it's simpler at the receive end.  But only the
+// header and data take time to send.
 void
 Network::Send(PacketHeader hdr, char* data)
 {
-    char toName[32];
+    OutPacket *packet;
 
-    sprintf(toName, "SOCKET_%d", (int)hdr.to);
-    
-    ASSERT((sendBusy == FALSE) && (hdr.length > 0) 
+    ASSERT((queued < link.queueSize) && (hdr.length > 0) 
 		&& (hdr.length <= MaxPacketSize) && (hdr.from == ident));
     DEBUG('n', "Sending to addr %d, %d bytes... ", hdr.to, hdr.length);
 
-    interrupt->Schedule(NetworkSendDone, (int)this, NetworkTime, NetworkSendInt);
-
-    if (Random() % 100 >= chanceToWork * 100) { // emulate a lost packet
+    packet = new OutPacket;
+    packet->net = this;
+    packet->size = sizeof(PacketHeader) + hdr.length;
+    packet->lost = (LoggedRandom() % 100 >= chanceToWork * 100);
+    if (packet->lost)				// emulate a lost packet
 	DEBUG('n', "oops, lost it!\n");
-	return;
-    }
 
-    // concatenate hdr and data into a single buffer, and send it out
-    char *buffer = new char[MaxWireSize];
-    *(PacketHeader *)buffer = hdr;
-    bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
-    SendToSocket(sock, buffer, MaxWireSize, toName);
-    delete []buffer;
+    // concatenate hdr and data into a single buffer, and queue it
+    *(PacketHeader *)packet->buffer = hdr;
+    bcopy(data, packet->buffer + sizeof(PacketHeader), hdr.length);
+    sendQueue->Append((void *)packet);
+    if (++queued == 1)
+	StartSending();
+
+    if (queued < link.queueSize)
+	interrupt->Schedule(NetworkWriteDone, (intptr_t) this, 1, NetworkSendInt);
+    else
+	writeWaiting = TRUE;
 }
 
 // read a packet, if one is buffered
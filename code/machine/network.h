@@ -17,6 +17,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "list.h"
 
 // Network address -- uniquely identifies a machine.  This machine's ID 
 //  is given on the command line.
@@ -40,7 +41,31 @@ class PacketHeader {
 #define MaxWireSize 	64	// largest packet that can go out on the wire
 #define MaxPacketSize 	(MaxWireSize - sizeof(struct PacketHeader))	
 				// data "payload" of the largest packet
+#define RecvBatchSize	32	// most packets taken from the host at once
 
+// The following class describes the link between this machine and the
+// others: how fast it sends, how long packets take to get there, and
+// how many packets can wait to be sent.  The default is the wire Nachos
+// has always had: NetworkTime per packet, whatever its size, with no
+// delay and no queue.
+
+class LinkModel {
+  public:
+    LinkModel() { bandwidth = 0; latency = 0; jitter = 0; queueSize = 1; }
+
+    int bandwidth;		// bytes per 1000 ticks, or 0 for
+				//   NetworkTime per packet
+    int latency;		// ticks from the end of sending a packet
+				//   to its arrival
+    int jitter;			// up to this many ticks more, at random
+				//   (packets still arrive in order)
+    int queueSize;		// packets that can be waiting to be sent,
+				//   counting the one being sent
+};
+
+
+class OutPacket;		// a packet on its way out, defined in
+				// network.cc
 
 // The following class defines a physical network device.  The network
 // is capable of delivering fixed sized packets, in order but unreliably, 
@@ -55,19 +80,22 @@ class PacketHeader {
 class Network {
   public:
     Network(NetworkAddress addr, double reliability,
-  	  VoidFunctionPtr readAvail, VoidFunctionPtr writeDone, int callArg);
-				// Allocate and initialize network driver
+  	  VoidFunctionPtr readAvail, VoidFunctionPtr writeDone, intptr_t callArg,
+	  LinkModel *link = NULL);
+				// Allocate and initialize network driver,
+				// on "link" if given, else the default
     ~Network();			// De-allocate the network driver data
     
     void Send(PacketHeader hdr, char* data);
     				// Send the packet data to a remote machine,
 				// specified by "hdr".  Returns immediately.
     				// "writeHandler" is invoked once the next 
-				// packet can be sent.  Note that writeHandler 
-				// is called whether or not the packet is 
-				// dropped, and note that the "from" field of 
-				// the PacketHeader is filled in automatically 
-				// by Send().
+				// packet can be sent -- that is, once there
+				// is room in the transmit queue.  Note that
+				// writeHandler is called whether or not the
+				// packet is dropped, and note that the "from"
+				// field of the PacketHeader is filled in 
+				// automatically by Send().
 
     PacketHeader Receive(char* data);
     				// Poll the network for incoming messages.  
@@ -78,7 +106,15 @@ class Network {
 
     void SendDone();		// Interrupt handler, called when message is 
 				// sent
+    void WriteDone();		// Interrupt handler, called to tell the
+				// user there is room for another packet
+    void PacketArrives(OutPacket *packet);
+				// Interrupt handler, called when a packet
+				// has crossed the link
     void CheckPktAvail();	// Check if there is an incoming packet
+    void SetReliability(double reliability);
+				// Change the chance that a packet is
+				// delivered, for packets sent from now on
 
   private:
     NetworkAddress ident;	// This machine's network address
@@ -89,13 +125,28 @@ class Network {
 				//      can be sent.  
     VoidFunctionPtr readHandler;  // Interrupt handler, signalling packet has 
 				// 	arrived.
-    int handlerArg;		// Argument to be passed to interrupt handler
+    intptr_t handlerArg;	// Argument to be passed to interrupt handler
 				//   (pointer to post office)
-    bool sendBusy;		// Packet is being sent.
+    LinkModel link;		// Speed, delay and queue of the link
+    int sendTime;		// Ticks to send (or receive) a full packet
+    OutPacket *sending;		// Packet being sent, if any
+    List *sendQueue;		// Packets waiting to be sent after it
+    int queued;			// How many there are, counting "sending"
+    bool writeWaiting;		// The user is waiting for room in the queue
+    int lastArrival;		// When the last packet sent will arrive
     bool packetAvail;		// Packet has arrived, can be pulled off of
 				//   network
     PacketHeader inHdr;		// Information about arrived packet
     char inbox[MaxPacketSize];  // Data for arrived packet
+    char *recvBatch;		// Packets read from the socket, but not
+				//   delivered yet, MaxWireSize bytes each
+    int recvNext;		// Next of them to deliver
+    int recvCount;		// How many of them are left
+
+    void FillRecvBatch();	// Read every packet waiting in the socket,
+				//   up to RecvBatchSize, into recvBatch
+    void StartSending();	// Start sending the next queued packet
+    int SendTime(int size);	// Ticks to send "size" bytes
 };
 
 #endif // NETWORK_H
@@ -22,6 +22,13 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    keepInstrMix = FALSE;
+    for (int i = 0; i < NumOpCodes; i++)
+	numOpExecuted[i] = 0;
+    numBranchesTaken = numBranchesNotTaken = 0;
+    numLoadStalls = numUnalignedLoads = numFusedPairs = 0;
+    keepDiskLatency = FALSE;
+    numTrackBufferHits = 0;
 }
 
 //----------------------------------------------------------------------
@@ -42,3 +49,157 @@ Statistics::Print()
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 }
+
+//----------------------------------------------------------------------
+// Statistics::WriteJson
+// 	Write the statistics, as members of a JSON object, to "fp".  The
+//	members below are always there, so that whatever reads them can
+//	count on it; "diskLatency" only with -dh.  Counters that weren't
+//	kept are 0.
+//----------------------------------------------------------------------
+
+void
+Statistics::WriteJson(FILE *fp)
+{
+    fprintf(fp, "  \"ticks\": {\"total\": %d, \"idle\": %d, "
+	"\"system\": %d, \"user\": %d},\n", totalTicks, idleTicks,
+	systemTicks, userTicks);
+    fprintf(fp, "  \"disk\": {\"reads\": %d, \"writes\": %d, "
+	"\"trackBufferHits\": %d},\n", numDiskReads, numDiskWrites,
+	numTrackBufferHits);
+    fprintf(fp, "  \"console\": {\"charsRead\": %d, "
+	"\"charsWritten\": %d},\n", numConsoleCharsRead,
+	numConsoleCharsWritten);
+    fprintf(fp, "  \"paging\": {\"faults\": %d},\n", numPageFaults);
+    fprintf(fp, "  \"network\": {\"packetsSent\": %d, "
+	"\"packetsRecvd\": %d},\n", numPacketsSent, numPacketsRecvd);
+    fprintf(fp, "  \"instructions\": {\"branchesTaken\": %d, "
+	"\"branchesNotTaken\": %d, \"loadStalls\": %d, "
+	"\"unalignedLoads\": %d, \"fusedPairs\": %d}", numBranchesTaken,
+	numBranchesNotTaken, numLoadStalls, numUnalignedLoads, numFusedPairs);
+    if (keepDiskLatency) {
+	fprintf(fp, ",\n  \"diskLatency\": {\n    \"queueWait\": ");
+	diskQueueWait.WriteJson(fp);
+	fprintf(fp, ",\n    \"seek\": ");
+	diskSeek.WriteJson(fp);
+	fprintf(fp, ",\n    \"rotation\": ");
+	diskRotation.WriteJson(fp);
+	fprintf(fp, ",\n    \"transfer\": ");
+	diskTransfer.WriteJson(fp);
+	fprintf(fp, ",\n    \"response\": ");
+	diskResponse.WriteJson(fp);
+	fprintf(fp, "\n  }");
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::RecordDiskRequest
+// 	Count the time the Disk takes for one request, split up as
+//	Disk::ComputeLatency figured it.
+//----------------------------------------------------------------------
+
+void
+Statistics::RecordDiskRequest(int seek, int rotation, int transfer, 
+				bool bufferHit)
+{
+    diskSeek.Record(seek);
+    diskRotation.Record(rotation);
+    diskTransfer.Record(transfer);
+    if (bufferHit)
+	numTrackBufferHits++;
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintDiskLatency
+// 	Print the histograms of disk request times, and how often reads
+//	were served from the track buffer.
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintDiskLatency()
+{
+    printf("Disk request times, in ticks:\n");
+    diskQueueWait.Print("queue wait");
+    diskSeek.Print("seek");
+    diskRotation.Print("rotation");
+    diskTransfer.Print("transfer");
+    diskResponse.Print("response");
+    if (numDiskReads > 0)
+	printf("Track buffer: %d of %d reads (%d%%)\n", numTrackBufferHits,
+	    numDiskReads, numTrackBufferHits * 100 / numDiskReads);
+}
+
+//----------------------------------------------------------------------
+// LatencyHistogram::LatencyHistogram
+// 	Initialize a histogram to empty.
+//----------------------------------------------------------------------
+
+LatencyHistogram::LatencyHistogram()
+{
+    count = longest = 0;
+    total = 0;
+    for (int i = 0; i < NumLatencyBuckets; i++)
+	buckets[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// LatencyHistogram::Record
+// 	Count one time, in the bucket for its highest bit.
+//----------------------------------------------------------------------
+
+void
+LatencyHistogram::Record(int ticks)
+{
+    int bucket = 0;
+
+    while ((ticks >> bucket) > 0 && bucket < NumLatencyBuckets - 1)
+	bucket++;
+    buckets[bucket]++;
+    count++;
+    total += ticks;
+    if (ticks > longest)
+	longest = ticks;
+}
+
+//----------------------------------------------------------------------
+// LatencyHistogram::Print
+// 	Print the count, mean and longest time, then one line for each
+//	bucket that isn't empty: its range, count and share of the total.
+//----------------------------------------------------------------------
+
+void
+LatencyHistogram::Print(char *name)
+{
+    int low, high;
+
+    printf("  %s: %d, mean %lld, longest %d\n", name, count,
+	(count > 0) ? total / count : 0, longest);
+    for (int i = 0; i < NumLatencyBuckets; i++) {
+	if (buckets[i] == 0)
+	    continue;
+	low = (i == 0) ? 0 : (1 << (i - 1));
+	high = (1 << i) - 1;
+	if (i == NumLatencyBuckets - 1)
+	    printf("    %8d -          %7d  %3d%%\n", low, buckets[i],
+		buckets[i] * 100 / count);
+	else
+	    printf("    %8d - %-8d %7d  %3d%%\n", low, high, buckets[i],
+		buckets[i] * 100 / count);
+    }
+}
+
+//----------------------------------------------------------------------
+// LatencyHistogram::WriteJson
+// 	Write the histogram to "fp" as a JSON object; "buckets" has all
+//	NumLatencyBuckets counts, bucket i for times below 2^i.
+//----------------------------------------------------------------------
+
+void
+LatencyHistogram::WriteJson(FILE *fp)
+{
+    fprintf(fp, "{\"count\": %d, \"total\": %lld, \"longest\": %d, "
+	"\"buckets\": [", count, total, longest);
+    for (int i = 0; i < NumLatencyBuckets; i++)
+	fprintf(fp, (i == 0) ? "%d" : ", %d", buckets[i]);
+    fprintf(fp, "]}");
+}
@@ -12,6 +12,29 @@
 #define STATS_H
 
 #include "copyright.h"
+#include "utility.h"
+
+#define NumOpCodes	64	// must be > MaxOpcode in machine/mipssim.h
+
+// The following class defines a histogram of times, in ticks, with
+// buckets that double in width: bucket 0 counts times of 0, bucket i
+// times from 2^(i-1) up to 2^i - 1, and the last one anything longer.
+
+#define NumLatencyBuckets	24
+
+class LatencyHistogram {
+  public:
+    LatencyHistogram();		// initialize to empty
+
+    void Record(int ticks);	// count one time
+    void Print(char *name);	// print the non-empty buckets
+    void WriteJson(FILE *fp);	// write it as a JSON object
+
+    int count;			// times counted
+    long long total;		// ... their sum
+    int longest;		// ... and the longest
+    int buckets[NumLatencyBuckets];
+};
 
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
@@ -36,9 +59,45 @@ class Statistics {
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
+// The instruction mix is only kept when asked for (-ms), since it
+// costs a few more host instructions per simulated one.
+
+    bool keepInstrMix;		// count the simulated instructions below?
+    int numOpExecuted[NumOpCodes]; // how often each opcode was executed,
+				// indexed by the OP_ codes in mipssim.h
+    int numBranchesTaken;	// conditional branches that jumped
+    int numBranchesNotTaken;	// ... and those that fell through
+    int numLoadStalls;		// instructions that read the register
+				// being loaded by the one just before them
+    int numUnalignedLoads;	// number of LWL/LWR instructions executed
+    int numFusedPairs;		// instruction pairs run in one step
+				// (kept whether or not -ms was given)
+
+// Disk request times are also only kept when asked for (-dh).  Each
+// request is timed from when it is handed to the SynchDisk, through
+// when it is sent to the Disk, to when the Disk says it is done.
+
+    bool keepDiskLatency;	// time the disk requests?
+    LatencyHistogram diskQueueWait;	// waiting for earlier requests
+    LatencyHistogram diskSeek;		// moving the head to the track
+    LatencyHistogram diskRotation;	// waiting for the sector to come
+					// under the head
+    LatencyHistogram diskTransfer;	// reading or writing the sector
+    LatencyHistogram diskResponse;	// all of the above
+    int numTrackBufferHits;	// reads served from the track buffer
+
     Statistics(); 		// initialize everything to zero
 
     void Print();		// print collected statistics
+    void RecordDiskRequest(int seek, int rotation, int transfer, 
+				bool bufferHit);
+				// count the time the Disk takes for one
+				// request
+    void PrintDiskLatency();	// print the disk request times
+    void WriteJson(FILE *fp);	// write the statistics as members of a
+				// JSON object (cf. ExportStats in
+				// system.cc)
+
 };
 
 // Constants used to reflect the relative time an operation would
@@ -35,7 +35,7 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
-#ifdef HOST_i386
+#if defined(HOST_i386) || defined(HOST_x86_64)
 #include <unistd.h>
 #include <sys/time.h>
 #include <errno.h>
@@ -56,7 +56,7 @@ extern "C" {
   //int creat(const char *name, unsigned short mode);
   //int open(const char *name, int flags, ...);
 // void signal(int sig, VoidFunctionPtr func); -- this may work now!
-#ifdef HOST_i386
+#if defined(HOST_i386) || defined(HOST_x86_64)
 int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
              struct timeval *timeout);
 #else
@@ -120,20 +120,30 @@ void exit(int);
 bool
 PollFile(int fd)
 {
-    int rfd = (1 << fd), wfd = 0, xfd = 0, retVal;
+    int retVal;
     struct timeval pollTime;
 
 // decide how long to wait if there are no characters on the file
     pollTime.tv_sec = 0;
     if (interrupt->getStatus() == IdleMode)
-        pollTime.tv_usec = 20000;              	// delay to let other nachos run
+        pollTime.tv_usec = 1000;              	// delay to let other nachos run
     else
         pollTime.tv_usec = 0;                 	// no delay
 
 // poll file or socket
-#if (defined(HOST_i386) || defined(HOST_SPARC)) 
-    retVal = select(32, (fd_set*)&rfd, (fd_set*)&wfd, (fd_set*)&xfd, &pollTime);
+#if defined(HOST_i386) || defined(HOST_SPARC) || defined(HOST_x86_64)
+    // The kernel copies fd_set in units of "long", so handing it an "int"
+    // bit mask (as we used to) overruns the stack on 64-bit hosts.
+    fd_set rfd, wfd, xfd;
+
+    FD_ZERO(&rfd);
+    FD_ZERO(&wfd);
+    FD_ZERO(&xfd);
+    FD_SET(fd, &rfd);
+    retVal = select(fd + 1, &rfd, &wfd, &xfd, &pollTime);
 #else
+    int rfd = (1 << fd), wfd = 0, xfd = 0;
+
     retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
 #endif
 
@@ -234,7 +244,7 @@ Lseek(int fd, int offset, int whence)
 int 
 Tell(int fd)
 {
-#ifdef HOST_i386
+#if defined(HOST_i386) || defined(HOST_x86_64)
     return lseek(fd,0,SEEK_CUR); // 386BSD doesn't have the tell() system call
 #else
     return tell(fd);
@@ -357,8 +367,8 @@ ReadFromSocket(int sockID, char *buffer, int packetSize)
     int retVal;
     //    extern int errno;	errno sometimes defined as a macro
     struct sockaddr_un uName;
-#ifdef HOST_i386
-    unsigned int size = sizeof(uName);
+#if defined(HOST_i386) || defined(HOST_x86_64)
+    socklen_t size = sizeof(uName);
 #else
     int size = sizeof(uName);
 #endif
@@ -368,15 +378,64 @@ ReadFromSocket(int sockID, char *buffer, int packetSize)
 
     if (retVal != packetSize) {
         perror("in recvfrom");
-        printf("called: %x, got back %d, %d\n", (unsigned int) buffer, retVal, errno);
+        printf("called: %p, got back %d, %d\n", buffer, retVal, errno);
     }
     ASSERT(retVal == packetSize);
 }
 
+//----------------------------------------------------------------------
+// ReadManyFromSocket
+// 	Read the fixed size packets waiting on the IPC port, up to 
+//	"maxPackets" of them, one after the other into "buffer", without
+//	waiting for more.  Return how many were read.  Abort on error.
+//
+//	On Linux, recvmmsg reads them all in one system call.
+//----------------------------------------------------------------------
+int
+ReadManyFromSocket(int sockID, char *buffer, int packetSize, int maxPackets)
+{
+    int retVal;
+#ifdef __linux__
+    struct mmsghdr *msgs = new struct mmsghdr[maxPackets];
+    struct iovec *iovecs = new struct iovec[maxPackets];
+    int i;
+
+    bzero((char *) msgs, maxPackets * sizeof(struct mmsghdr));
+    for (i = 0; i < maxPackets; i++) {
+	iovecs[i].iov_base = buffer + i * packetSize;
+	iovecs[i].iov_len = packetSize;
+	msgs[i].msg_hdr.msg_iov = &iovecs[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    retVal = recvmmsg(sockID, msgs, maxPackets, MSG_DONTWAIT, NULL);
+    if ((retVal < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+	retVal = 0;
+    ASSERT(retVal >= 0);
+    for (i = 0; i < retVal; i++)
+	ASSERT((int) msgs[i].msg_len == packetSize);
+    delete [] msgs;
+    delete [] iovecs;
+    return retVal;
+#else
+    int n;
+
+    for (n = 0; n < maxPackets; n++) {
+	retVal = recvfrom(sockID, buffer + n * packetSize, packetSize,
+				MSG_DONTWAIT, NULL, NULL);
+	if ((retVal < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+	    break;
+	ASSERT(retVal == packetSize);
+    }
+    return n;
+#endif
+}
+
 //----------------------------------------------------------------------
 // SendToSocket
 // 	Transmit a fixed size packet to another Nachos' IPC port.
-//	Abort on error.
+//	If no Nachos is listening there (it has halted, or hasn't 
+//	started yet), the packet is lost, as on a real network.
+//	Abort on any other error.
 //----------------------------------------------------------------------
 void
 SendToSocket(int sockID, char *buffer, int packetSize, char *toName)
@@ -387,6 +446,8 @@ SendToSocket(int sockID, char *buffer, int packetSize, char *toName)
     InitSocketName(&uName, toName);
     retVal = sendto(sockID, buffer, packetSize, 0,
 			   (sockaddr*) &uName, sizeof(uName));
+    if ((retVal < 0) && ((errno == ENOENT) || (errno == ECONNREFUSED)))
+	return;
     ASSERT(retVal == packetSize);
 }
 
@@ -400,7 +461,62 @@ SendToSocket(int sockID, char *buffer, int packetSize, char *toName)
 void 
 CallOnUserAbort(VoidNoArgFunctionPtr func)
 {
-    (void)signal(SIGINT, (VoidFunctionPtr) func);
+    (void)signal(SIGINT, (void (*)(int)) func);
+}
+
+//----------------------------------------------------------------------
+// CallOnAbort
+// 	Arrange that "func" will be called when Nachos is about to
+//	abort, from Abort.  "func" should only save state to files; it
+//	is not called again if it fails in turn.
+//----------------------------------------------------------------------
+
+static VoidNoArgFunctionPtr abortHandler = NULL;
+
+void 
+CallOnAbort(VoidNoArgFunctionPtr func)
+{
+    abortHandler = func;
+}
+
+//----------------------------------------------------------------------
+// CallOnBadAddress
+// 	Arrange that "func" will be called, with the address referenced,
+//	when Nachos itself touches memory it may not -- such as the guard
+//	pages around a bounded array.  "func" must not return.
+//
+//	The handler runs on a stack of its own, since the stack in use 
+//	when the fault happened may well be the one that overflowed.
+//----------------------------------------------------------------------
+
+#define SignalStackSize	(64 * 1024)
+
+static void (*badAddressHandler)(char *addr);
+
+static void
+BadAddressSignal(int sig, siginfo_t *info, void *context)
+{
+    (*badAddressHandler)((char *) info->si_addr);
+}
+
+void 
+CallOnBadAddress(void (*func)(char *addr))
+{
+    stack_t signalStack;
+    struct sigaction action;
+
+    badAddressHandler = func;
+    signalStack.ss_sp = new char[SignalStackSize];
+    signalStack.ss_size = SignalStackSize;
+    signalStack.ss_flags = 0;
+    (void) sigaltstack(&signalStack, NULL);
+
+    memset((char *) &action, 0, sizeof(action));
+    action.sa_sigaction = BadAddressSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    (void) sigaction(SIGSEGV, &action, NULL);
+    (void) sigaction(SIGBUS, &action, NULL);
 }
 
 //----------------------------------------------------------------------
@@ -416,14 +532,37 @@ Delay(int seconds)
     (void) sleep((unsigned) seconds);
 }
 
+//----------------------------------------------------------------------
+// HostSeconds
+// 	Return the UNIX time of day, in seconds, to the microsecond.
+//	Used to measure how long Nachos itself takes to run something,
+//	as opposed to the simulated time in "stats".
+//----------------------------------------------------------------------
+
+double
+HostSeconds()
+{
+    struct timeval now;
+
+    (void) gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // Abort
-// 	Quit and drop core.
+// 	Quit and drop core, after calling the CallOnAbort function, if
+//	any.
 //----------------------------------------------------------------------
 
 void 
 Abort()
 {
+    VoidNoArgFunctionPtr func = abortHandler;
+
+    if (func != NULL) {
+	abortHandler = NULL;		// in case it aborts too
+	(*func)();
+    }
     abort();
 }
 
@@ -438,6 +577,13 @@ Exit(int exitCode)
     exit(exitCode);
 }
 
+// The C library won't tell us where its generator is, so to let a 
+// checkpoint reproduce it we remember the seed and how many numbers
+// have been drawn since.
+
+static unsigned randomSeed = 1;		// the default, if never seeded
+static int randomCalls = 0;
+
 //----------------------------------------------------------------------
 // RandomInit
 // 	Initialize the pseudo-random number generator.  We use the
@@ -448,6 +594,8 @@ void
 RandomInit(unsigned seed)
 {
     srand(seed);
+    randomSeed = seed;
+    randomCalls = 0;
 }
 
 //----------------------------------------------------------------------
@@ -458,9 +606,32 @@ RandomInit(unsigned seed)
 int 
 Random()
 {
+    randomCalls++;
     return rand();
 }
 
+//----------------------------------------------------------------------
+// RandomGetState, RandomSetState
+// 	Save and restore the position of the pseudo-random number
+//	generator, for checkpointing.  Restoring re-seeds the generator
+//	and draws "calls" numbers to catch up with where it was.
+//----------------------------------------------------------------------
+
+void
+RandomGetState(unsigned *seed, int *calls)
+{
+    *seed = randomSeed;
+    *calls = randomCalls;
+}
+
+void
+RandomSetState(unsigned seed, int calls)
+{
+    RandomInit(seed);
+    while (randomCalls < calls)
+	(void) Random();
+}
+
 //----------------------------------------------------------------------
 // AllocBoundedArray
 // 	Return an array, with the two pages just before 
@@ -468,6 +639,12 @@ Random()
 //	the end of the array.  Particularly useful for catching overflow
 //	beyond fixed-size thread execution stacks.
 //
+//	The array is mapped on its own, so that it starts on a page
+//	boundary, and the guard pages can be protected without touching
+//	anything else.  The guard page after the array follows the
+//	end of its last page, so unless "size" is a multiple of the page
+//	size, there is a little slack before it.
+//
 //	Note: Just return the useful part!
 //
 //	"size" -- amount of useful space needed (in bytes)
@@ -477,16 +654,20 @@ char *
 AllocBoundedArray(int size)
 {
     int pgSize = getpagesize();
-    char *ptr = new char[pgSize * 2 + size];
+    int mapped = divRoundUp(size, pgSize) * pgSize;
+    char *ptr = (char *) mmap(NULL, pgSize * 2 + mapped, 
+		PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-    //mprotect(ptr, pgSize, 0);
-    //mprotect(ptr + pgSize + size, pgSize, 0);
+    ASSERT(ptr != (char *) MAP_FAILED);
+    mprotect(ptr, pgSize, PROT_NONE);
+    mprotect(ptr + pgSize + mapped, pgSize, PROT_NONE);
     return ptr + pgSize;
 }
 
 //----------------------------------------------------------------------
 // DeallocBoundedArray
-// 	Deallocate an array of integers, unprotecting its two boundary pages.
+// 	Deallocate an array allocated by AllocBoundedArray, along with
+//	its two boundary pages.
 //
 //	"ptr" -- the array to be deallocated
 //	"size" -- amount of useful space in the array (in bytes)
@@ -496,8 +677,28 @@ void
 DeallocBoundedArray(char *ptr, int size)
 {
     int pgSize = getpagesize();
+    int mapped = divRoundUp(size, pgSize) * pgSize;
+
+    munmap(ptr - pgSize, pgSize * 2 + mapped);
+}
+
+//----------------------------------------------------------------------
+// InBoundedArrayGuard
+// 	Return TRUE if "addr" is in one of the two boundary pages of an
+//	array allocated by AllocBoundedArray -- ie, a reference off the
+//	end of the array.
+//
+//	"ptr" -- the array
+//	"size" -- amount of useful space in the array (in bytes)
+//	"addr" -- the address referenced
+//----------------------------------------------------------------------
+
+bool
+InBoundedArrayGuard(char *ptr, int size, char *addr)
+{
+    int pgSize = getpagesize();
+    char *end = ptr + divRoundUp(size, pgSize) * pgSize;
 
-    mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    delete [] (ptr - pgSize);
+    return ((addr >= ptr - pgSize) && (addr < ptr)) || 
+				((addr >= end) && (addr < end + pgSize));
 }
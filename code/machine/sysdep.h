@@ -36,24 +36,37 @@ extern void AssignNameToSocket(char *socketName, int sockID);
 extern void DeAssignNameToSocket(char *socketName);
 extern bool PollSocket(int sockID);
 extern void ReadFromSocket(int sockID, char *buffer, int packetSize);
+extern int ReadManyFromSocket(int sockID, char *buffer, int packetSize,
+							int maxPackets);
 extern void SendToSocket(int sockID, char *buffer, int packetSize,char *toName);
 
 // Process control: abort, exit, and sleep
 extern void Abort();
 extern void Exit(int exitCode);
 extern void Delay(int seconds);
+extern double HostSeconds();		// UNIX time, for timing Nachos itself
 
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 
+// ... and so that "func" is called just before Nachos aborts (eg. when
+// an ASSERT fails), to save what can't be left behind
+extern void CallOnAbort(VoidNoArgFunctionPtr func);
+
+// ... and so that "func" is called when Nachos references a bad address
+extern void CallOnBadAddress(void (*func)(char *addr));
+
 // Initialize the pseudo random number generator
 extern void RandomInit(unsigned seed);
 extern int Random();
+extern void RandomGetState(unsigned *seed, int *calls);
+extern void RandomSetState(unsigned seed, int calls);
 
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
+extern bool InBoundedArrayGuard(char *p, int size, char *addr);
 
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
@@ -0,0 +1,393 @@
+// nettest.cc
+//	Test out message delivery between two "Nachos" machines,
+//	using the Post Office to coordinate delivery.
+//
+//	Two copies of Nachos must be running, in the same directory, with
+//	machine ID's 0 and 1:
+//		./nachos -m 0 -o 1 &
+//		./nachos -m 1 -o 0 &
+//
+//	The same goes for the test of reliable transport, with -ot instead
+//	of -o; add "-l 0.9", say, to make the network lose packets.  For the
+//	remote file system, one machine serves with -os, the other runs
+//	the test with -oc.  The network benchmark, -ob, runs on both
+//	machines; the one with the lower ID prints the results.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#include "system.h"
+#include "network.h"
+#include "post.h"
+#include "transport.h"
+#include "remotefs.h"
+#include "interrupt.h"
+
+// Test out message delivery, by doing the following:
+//	1. send a message to the machine with ID "farAddr", at mail box #0
+//	2. wait for the other machine's message to arrive (in our mailbox #0)
+//	3. send an acknowledgment for the other machine's message
+//	4. wait for an acknowledgement from the other machine to our
+//	    original message
+
+void
+MailTest(int farAddr)
+{
+    PacketHeader outPktHdr, inPktHdr;
+    MailHeader outMailHdr, inMailHdr;
+    char *data = "Hello there!";
+    char *ack = "Got it!";
+    char buffer[MaxMailSize];
+
+    // construct packet, mail header for original message
+    // To: destination machine, mailbox 0
+    // From: our machine, reply to: mailbox 1
+    outPktHdr.to = farAddr;
+    outMailHdr.to = 0;
+    outMailHdr.from = 1;
+    outMailHdr.length = strlen(data) + 1;
+
+    // Send the first message
+    postOffice->Send(outPktHdr, outMailHdr, data);
+
+    // Wait for the first message from the other machine
+    postOffice->Receive(0, &inPktHdr, &inMailHdr, buffer);
+    printf("Got \"%s\" from %d, box %d\n",buffer,inPktHdr.from,inMailHdr.from);
+    fflush(stdout);
+
+    // Send acknowledgement to the other machine (using "reply to" mailbox
+    // in the message that just arrived
+    outPktHdr.to = inPktHdr.from;
+    outMailHdr.to = inMailHdr.from;
+    outMailHdr.length = strlen(ack) + 1;
+    postOffice->Send(outPktHdr, outMailHdr, ack);
+
+    // Wait for the ack from the other machine to the first message we sent.
+    postOffice->Receive(1, &inPktHdr, &inMailHdr, buffer);
+    printf("Got \"%s\" from %d, box %d\n",buffer,inPktHdr.from,inMailHdr.from);
+    fflush(stdout);
+
+    // Then we're done!
+    interrupt->Halt();
+}
+
+// Test out reliable transport, by having both machines send each other
+// the same series of messages, of all sizes, at the same time, over a
+// connection between their mailboxes #2.  Each checks what it receives,
+// and prints how fast the data got through.
+
+#define TransportBox		2
+#define TransportWindow		16
+#define NumTransportMessages	24
+
+static Semaphore *transportSent;	// V'ed when all messages are sent
+
+//----------------------------------------------------------------------
+// MessageSize, FillMessage
+// 	Size and contents of the transport test messages: from empty to
+//	several hundred segments long, with a pattern that shows data
+//	out of place.
+//----------------------------------------------------------------------
+
+static int
+MessageSize(int which)
+{
+    return (which * which * 37) % 4000;
+}
+
+static void
+FillMessage(char *buffer, int which)
+{
+    int i;
+
+    for (i = 0; i < MessageSize(which); i++)
+	buffer[i] = (char) (which * 31 + i + i / 251);
+}
+
+//----------------------------------------------------------------------
+// TransportSender
+// 	Send all the test messages; forked, so both directions are busy
+//	at once.
+//----------------------------------------------------------------------
+
+static void
+TransportSender(intptr_t arg)
+{
+    Connection *conn = (Connection *) arg;
+    char *buffer = new char[4000];
+    int i;
+
+    for (i = 0; i < NumTransportMessages; i++) {
+	FillMessage(buffer, i);
+	conn->Send(buffer, MessageSize(i));
+    }
+    delete [] buffer;
+    transportSent->V();
+}
+
+void
+TransportTest(int farAddr)
+{
+    Connection *conn = new Connection(farAddr, TransportBox, TransportBox,
+							TransportWindow);
+    char *expected = new char[4000];
+    char *buffer = new char[4000];
+    int start = stats->totalTicks;
+    int i, length, bytes = 0, bad = 0, ticks;
+    Thread *t = new Thread("transport sender");
+
+    transportSent = new Semaphore("transport sent", 0);
+    t->Fork(TransportSender, (intptr_t) conn);
+
+    for (i = 0; i < NumTransportMessages; i++) {
+	length = conn->Receive(buffer, 4000);
+	FillMessage(expected, i);
+	if ((length != MessageSize(i)) || bcmp(buffer, expected, length)) {
+	    printf("Message %d: got %d bytes, wrong\n", i, length);
+	    bad++;
+	}
+	bytes += length;
+    }
+    ticks = stats->totalTicks - start;
+    transportSent->P();
+    conn->Close(2 * MaxTimeout);
+
+    printf("Transport: %d of %d messages ok, %d bytes in %d ticks, "
+	"%d bytes per 1000 ticks\n", NumTransportMessages - bad,
+	NumTransportMessages, bytes, ticks, (int) (bytes * 1000LL / ticks));
+    printf("Transport: segments sent %d, resent %d, acks %d, dropped %d\n",
+	conn->segmentsSent, conn->segmentsResent, conn->acksSent,
+	conn->segmentsDropped);
+    fflush(stdout);
+
+    interrupt->Halt();
+}
+
+// Test out the remote file system: the client writes a file on the
+// server, in small pieces, then reads it back in order, first with
+// read-ahead and then without, checking what it gets and printing how
+// fast each pass went.
+
+#define RemoteFileBox		3
+#define RemoteFileName		"rfs.test"
+#define RemoteFileSize		(128 * RemoteBlockSize)
+#define RemoteChunk		100	// bytes per Read or Write
+
+//----------------------------------------------------------------------
+// FileServerTest
+// 	Serve our files to the client at "farAddr", until it is done.
+//----------------------------------------------------------------------
+
+void
+FileServerTest(int farAddr)
+{
+    FileServer *server = new FileServer(farAddr, RemoteFileBox);
+
+    server->Serve();
+    printf("File server: %d requests\n", server->requests);
+    fflush(stdout);
+    delete server;
+
+    interrupt->Halt();
+}
+
+//----------------------------------------------------------------------
+// RemoteReadPass
+// 	Read the test file in order, check it, and print how fast it went.
+//----------------------------------------------------------------------
+
+static void
+RemoteReadPass(RemoteFileSystem *rfs, char *what)
+{
+    RemoteFile *file = rfs->Open(RemoteFileName);
+    char buffer[RemoteChunk];
+    int start = stats->totalTicks;
+    int hits = rfs->cacheHits, misses = rfs->cacheMisses;
+    int i, n, bytes = 0, bad = 0, ticks;
+
+    ASSERT(file != NULL);
+    while ((n = file->Read(buffer, RemoteChunk)) > 0) {
+	for (i = 0; i < n; i++)
+	    if (buffer[i] != (char) ((bytes + i) * 7 + (bytes + i) / 253))
+		bad++;
+	bytes += n;
+    }
+    delete file;
+    ticks = stats->totalTicks - start;
+
+    printf("Remote read, %s: %d bytes, %d wrong, in %d ticks, "
+	"%d bytes per 1000 ticks; cache hits %d, misses %d\n", what,
+	bytes, bad, ticks, (int) (bytes * 1000LL / ticks),
+	rfs->cacheHits - hits, rfs->cacheMisses - misses);
+}
+
+//----------------------------------------------------------------------
+// RemoteFileTest
+// 	Use the files of the server at "farAddr".
+//----------------------------------------------------------------------
+
+void
+RemoteFileTest(int farAddr)
+{
+    RemoteFileSystem *rfs = new RemoteFileSystem(farAddr, RemoteFileBox);
+    RemoteFile *file;
+    char buffer[RemoteChunk];
+    int start, ticks, i, done;
+
+    if (!rfs->Create(RemoteFileName, 0)) {
+	printf("Remote create of %s failed\n", RemoteFileName);
+	delete rfs;
+	interrupt->Halt();
+    }
+    file = rfs->Open(RemoteFileName);
+    ASSERT(file != NULL);
+
+    start = stats->totalTicks;
+    for (done = 0; done < RemoteFileSize; done += RemoteChunk) {
+	for (i = 0; i < RemoteChunk; i++)
+	    buffer[i] = (char) ((done + i) * 7 + (done + i) / 253);
+	file->Write(buffer, min(RemoteChunk, RemoteFileSize - done));
+    }
+    delete file;			// answered once the writes are done
+    ticks = stats->totalTicks - start;
+    file = rfs->Open(RemoteFileName);
+    ASSERT(file != NULL && file->Length() == RemoteFileSize);
+    delete file;
+    printf("Remote write: %d bytes in %d ticks, %d bytes per 1000 ticks, "
+	"%d files with failed writes\n", RemoteFileSize, ticks,
+	(int) (RemoteFileSize * 1000LL / ticks), rfs->writeErrors);
+
+    RemoteReadPass(rfs, "read-ahead");
+    rfs->SetReadAhead(0);
+    RemoteReadPass(rfs, "no read-ahead");
+    printf("Remote file system: %d blocks read ahead\n", rfs->blocksAhead);
+    fflush(stdout);
+
+    rfs->Remove(RemoteFileName);
+    delete rfs;
+    interrupt->Halt();
+}
+
+// Benchmark the network stack: for each network reliability, and each
+// message size, time
+//	ping-pong -- a message sent back and forth, over and over: the
+//	    round trip time, in ticks per round trip;
+//	stream -- messages sent one way, as fast as the window allows,
+//	    and answered once at the end: ticks per message, and goodput
+//	    (bytes of messages delivered per 1000 ticks).
+// Both machines run the same sweep, over a connection between their
+// mailboxes #4; the one with the lower ID measures, the other answers.
+// Resent segments and packets sent and received are counted on the
+// measuring machine.
+
+#define BenchBox		4
+#define BenchWindow		16
+#define BenchRounds		10	// round trips per ping-pong
+#define BenchStreamBytes	8192	// bytes per stream
+
+static double benchReliability[] = { 1.0, 0.95, 0.9 };
+static int benchSizes[] = { 16, 128, 1024, 4096 };
+
+#define NumBenchReliability	(int) (sizeof(benchReliability) / sizeof(double))
+#define NumBenchSizes		(int) (sizeof(benchSizes) / sizeof(int))
+#define MaxBenchMessage		4096
+
+static int benchStart, benchResent, benchSent, benchRecvd;
+
+//----------------------------------------------------------------------
+// BenchStart, BenchReport
+// 	Note the counters at the start of a benchmark, and print how it
+//	went: "messages" messages, of "size" bytes each, one way.
+//----------------------------------------------------------------------
+
+static void
+BenchStart(Connection *conn)
+{
+    benchStart = stats->totalTicks;
+    benchResent = conn->segmentsResent;
+    benchSent = stats->numPacketsSent;
+    benchRecvd = stats->numPacketsRecvd;
+}
+
+static void
+BenchReport(Connection *conn, char *test, double reliability, int size,
+							int messages)
+{
+    int ticks = stats->totalTicks - benchStart;
+
+    printf("%-9s %5.2f %6d %10d %10d %8d %8d %8d\n", test, reliability,
+	size, ticks / messages, (int) (size * (long long) messages * 1000
+							/ ticks),
+	conn->segmentsResent - benchResent,
+	stats->numPacketsSent - benchSent,
+	stats->numPacketsRecvd - benchRecvd);
+    fflush(stdout);
+}
+
+//----------------------------------------------------------------------
+// NetworkBenchmark
+// 	Run the benchmark with the machine at "farAddr", then halt.
+//----------------------------------------------------------------------
+
+void
+NetworkBenchmark(int farAddr)
+{
+    Connection *conn = new Connection(farAddr, BenchBox, BenchBox,
+								BenchWindow);
+    bool measure = (postOffice->Address() < farAddr);
+    char *buffer = new char[MaxBenchMessage];
+    int r, s, i, size, messages, length;
+    double reliability;
+
+    bzero(buffer, MaxBenchMessage);
+    if (measure)
+	printf("%-9s %5s %6s %10s %10s %8s %8s %8s\n", "test", "rely",
+	    "size", "ticks/msg", "goodput", "resent", "pktsSent",
+	    "pktsRecvd");
+
+    for (r = 0; r < NumBenchReliability; r++) {
+	reliability = benchReliability[r];
+	postOffice->SetReliability(reliability);
+	for (s = 0; s < NumBenchSizes; s++) {
+	    size = benchSizes[s];
+
+	    // ping-pong
+	    BenchStart(conn);
+	    for (i = 0; i < BenchRounds; i++)
+		if (measure) {
+		    conn->Send(buffer, size);
+		    length = conn->Receive(buffer, MaxBenchMessage);
+		    ASSERT(length == size);
+		} else {
+		    length = conn->Receive(buffer, MaxBenchMessage);
+		    ASSERT(length == size);
+		    conn->Send(buffer, size);
+		}
+	    if (measure)
+		BenchReport(conn, "ping-pong", reliability, size, BenchRounds);
+
+	    // stream
+	    messages = BenchStreamBytes / size;
+	    BenchStart(conn);
+	    if (measure) {
+		for (i = 0; i < messages; i++)
+		    conn->Send(buffer, size);
+		conn->Receive(buffer, MaxBenchMessage);
+		BenchReport(conn, "stream", reliability, size, messages);
+	    } else {
+		for (i = 0; i < messages; i++) {
+		    length = conn->Receive(buffer, MaxBenchMessage);
+		    ASSERT(length == size);
+		}
+		conn->Send(buffer, 1);
+	    }
+	}
+    }
+
+    delete [] buffer;
+    conn->Close(2 * MaxTimeout);
+    interrupt->Halt();
+}
@@ -0,0 +1,635 @@
+// remotefs.cc
+//	Routines for using the file system of another Nachos over the
+//	network: a server that carries out file requests, and a client
+//	that caches the blocks it reads, reads ahead of sequential
+//	readers, and sends writes without waiting for them.
+//
+//	The server remembers a write it couldn't make in full, and says
+//	so in its next reply about the file.  Every such reply also gives
+//	the file's length, which is all the client takes the file's length
+//	to be.
+//
+//	Every request that has a reply is answered in order, so the client
+//	keeps the blocks it has asked for in a list, and matches each reply
+//	to the block at the head of the list.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "remotefs.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// FileServer::FileServer
+// 	Initialize the server end of a remote file system.
+//
+//	"client" -- the machine using our files
+//	"box" -- the mailbox for the connection, on both machines
+//----------------------------------------------------------------------
+
+FileServer::FileServer(NetworkAddress client, MailBoxAddress box)
+{
+    conn = new Connection(client, box, box, RemoteWindow);
+    for (int i = 0; i < MaxRemoteFiles; i++) {
+	files[i] = NULL;
+	writeFailed[i] = FALSE;
+    }
+    requests = 0;
+}
+
+//----------------------------------------------------------------------
+// FileServer::~FileServer
+// 	Close the files the client left open.  The connection stays, as
+//	it is never de-allocated.
+//----------------------------------------------------------------------
+
+FileServer::~FileServer()
+{
+    for (int i = 0; i < MaxRemoteFiles; i++)
+	if (files[i] != NULL)
+	    delete files[i];
+}
+
+//----------------------------------------------------------------------
+// FileServer::Serve
+// 	Carry out the client's requests, in the order they arrive, until
+//	it unmounts.  Then linger on the connection, so that the client
+//	gets our last acknowledgements.
+//
+//	Requests for files that aren't open, or that don't make sense, are
+//	answered with an error when they expect an answer, and otherwise
+//	ignored.  A write that falls short is noted, and reported with
+//	the next reply about the file.
+//----------------------------------------------------------------------
+
+void
+FileServer::Serve()
+{
+    char *buffer = new char[MaxRemoteMessage];
+    char *reply = new char[MaxRemoteMessage];
+    char name[MaxRemoteName];
+    RemoteRequest request;
+    RemoteReply replyHdr;
+    OpenFile *file;
+    char *data = buffer + sizeof(RemoteRequest);
+    int length, dataLength, id, n;
+
+    for (;;) {
+	length = conn->Receive(buffer, MaxRemoteMessage);
+	if (length < (int) sizeof(RemoteRequest)) {
+	    DEBUG('n', "File server: short request, %d bytes\n", length);
+	    continue;
+	}
+	bcopy(buffer, (char *) &request, sizeof(RemoteRequest));
+	dataLength = length - sizeof(RemoteRequest);
+	id = request.fileId;
+	file = (id >= 0 && id < MaxRemoteFiles) ? files[id] : NULL;
+	replyHdr.status = -1;
+	replyHdr.fileLength = 0;
+	replyHdr.writeFailed = FALSE;
+	requests++;
+
+	switch (request.op) {
+	  case RemoteCreate:
+	  case RemoteRemove:
+	  case RemoteOpen:
+	    n = min(dataLength, MaxRemoteName - 1);
+	    bcopy(data, name, n);
+	    name[n] = '\0';
+	    DEBUG('n', "File server: op %d on \"%s\"\n", request.op, name);
+	    if (request.op == RemoteCreate)
+		replyHdr.status = fileSystem->Create(name, request.length);
+	    else if (request.op == RemoteRemove)
+		replyHdr.status = fileSystem->Remove(name);
+	    else {
+		for (id = 0; id < MaxRemoteFiles; id++)
+		    if (files[id] == NULL)
+			break;
+		if (id < MaxRemoteFiles
+			&& (files[id] = fileSystem->Open(name)) != NULL) {
+		    writeFailed[id] = FALSE;
+		    replyHdr.status = id;
+		    replyHdr.fileLength = files[id]->Length();
+		}
+	    }
+	    conn->Send((char *) &replyHdr, sizeof(RemoteReply));
+	    break;
+
+	  case RemoteRead:
+	    n = 0;
+	    if (file != NULL && request.position >= 0 && request.length > 0)
+		n = file->ReadAt(reply + sizeof(RemoteReply),
+			min(request.length, RemoteBlockSize), request.position);
+	    if (file != NULL) {
+		replyHdr.status = n;
+		replyHdr.fileLength = file->Length();
+		replyHdr.writeFailed = writeFailed[id];
+		writeFailed[id] = FALSE;
+	    }
+	    bcopy((char *) &replyHdr, reply, sizeof(RemoteReply));
+	    conn->Send(reply, sizeof(RemoteReply) + max(n, 0));
+	    break;
+
+	  case RemoteWrite:
+	    if (file == NULL) {
+		DEBUG('n', "File server: write to file %d, not open\n", id);
+		break;
+	    }
+	    n = (request.position < 0) ? 0
+			: file->WriteAt(data, dataLength, request.position);
+	    if (n != dataLength) {
+		DEBUG('n', "File server: wrote %d of %d bytes to file %d\n",
+			n, dataLength, id);
+		writeFailed[id] = TRUE;
+	    }
+	    break;
+
+	  case RemoteClose:
+	    if (file != NULL) {
+		replyHdr.status = 0;
+		replyHdr.fileLength = file->Length();
+		replyHdr.writeFailed = writeFailed[id];
+		delete file;
+		files[id] = NULL;
+	    }
+	    conn->Send((char *) &replyHdr, sizeof(RemoteReply));
+	    break;
+
+	  case RemoteUnmount:
+	    DEBUG('n', "File server: unmounted after %d requests\n", requests);
+	    delete [] buffer;
+	    delete [] reply;
+	    conn->Close(RemoteLinger);
+	    return;
+
+	  default:
+	    DEBUG('n', "File server: unknown request %d\n", request.op);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::RemoteFileSystem
+// 	Initialize the client end of a remote file system, with an empty
+//	cache.
+//
+//	"server" -- the machine with the files
+//	"box" -- the mailbox for the connection, on both machines
+//	"ahead" -- how many blocks to ask for ahead of a reader
+//----------------------------------------------------------------------
+
+RemoteFileSystem::RemoteFileSystem(NetworkAddress server, MailBoxAddress box,
+								int ahead)
+{
+    conn = new Connection(server, box, box, RemoteWindow);
+    lock = new Lock("remote file system");
+    readAhead = ahead;
+    cache = new RemoteBlock[RemoteCacheBlocks];
+    for (int i = 0; i < RemoteCacheBlocks; i++) {
+	cache[i].file = NULL;
+	cache[i].pending = FALSE;
+	cache[i].lastUsed = 0;
+    }
+    useCount = 0;
+    awaiting = new List;
+    buffer = new char[MaxRemoteMessage];
+    cacheHits = cacheMisses = blocksAhead = writeErrors = 0;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::~RemoteFileSystem
+// 	Tell the server we are done, and linger until it has heard
+//	everything we sent.  Files still open are closed by the server.
+//----------------------------------------------------------------------
+
+RemoteFileSystem::~RemoteFileSystem()
+{
+    RemoteRequest request;
+
+    lock->Acquire();
+    while (!awaiting->IsEmpty())
+	ReceiveBlock();
+    request.op = RemoteUnmount;
+    request.fileId = request.position = request.length = 0;
+    Request(&request, NULL, 0);
+    conn->Close(RemoteLinger);
+    lock->Release();
+
+    delete lock;
+    delete [] cache;
+    delete awaiting;
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Create, Remove, Open
+// 	Ask the server to create, remove or open a file, and wait for the
+//	answer.
+//----------------------------------------------------------------------
+
+bool
+RemoteFileSystem::Create(char *name, int initialSize)
+{
+    RemoteRequest request;
+    RemoteReply reply;
+
+    request.op = RemoteCreate;
+    request.fileId = request.position = 0;
+    request.length = initialSize;
+    lock->Acquire();
+    Call(&request, name, strlen(name), &reply);
+    lock->Release();
+    return reply.status == TRUE;
+}
+
+bool
+RemoteFileSystem::Remove(char *name)
+{
+    RemoteRequest request;
+    RemoteReply reply;
+
+    request.op = RemoteRemove;
+    request.fileId = request.position = request.length = 0;
+    lock->Acquire();
+    Call(&request, name, strlen(name), &reply);
+    lock->Release();
+    return reply.status == TRUE;
+}
+
+RemoteFile *
+RemoteFileSystem::Open(char *name)
+{
+    RemoteRequest request;
+    RemoteReply reply;
+
+    request.op = RemoteOpen;
+    request.fileId = request.position = request.length = 0;
+    lock->Acquire();
+    Call(&request, name, strlen(name), &reply);
+    lock->Release();
+    if (reply.status < 0)
+	return NULL;
+    return new RemoteFile(this, reply.status, reply.fileLength);
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Request
+// 	Send a request, with "dataLength" bytes of "data" after it, and
+//	go on without waiting.  The caller holds the lock.
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::Request(RemoteRequest *request, char *data, int dataLength)
+{
+    ASSERT(dataLength <= (int) (MaxRemoteMessage - sizeof(RemoteRequest)));
+    bcopy((char *) request, buffer, sizeof(RemoteRequest));
+    if (dataLength > 0)
+	bcopy(data, buffer + sizeof(RemoteRequest), dataLength);
+    conn->Send(buffer, sizeof(RemoteRequest) + dataLength);
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Call
+// 	Send a request and wait for its reply.  The replies to the blocks
+//	already asked for come first, so take them in on the way.  Return
+//	the length of the data after the reply header, left in "buffer".
+//	The caller holds the lock.
+//----------------------------------------------------------------------
+
+int
+RemoteFileSystem::Call(RemoteRequest *request, char *data, int dataLength,
+							RemoteReply *reply)
+{
+    int length;
+
+    while (!awaiting->IsEmpty())
+	ReceiveBlock();
+    Request(request, data, dataLength);
+    length = conn->Receive(buffer, MaxRemoteMessage);
+    ASSERT(length >= (int) sizeof(RemoteReply));
+    bcopy(buffer, (char *) reply, sizeof(RemoteReply));
+    return length - sizeof(RemoteReply);
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::ReceiveBlock
+// 	Wait for the next reply, which is for the oldest block asked for,
+//	and fill the block in.  The caller holds the lock.
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::ReceiveBlock()
+{
+    RemoteBlock *block = (RemoteBlock *) awaiting->Remove();
+    RemoteReply reply;
+    int length;
+
+    ASSERT(block != NULL && block->pending);
+    length = conn->Receive(buffer, MaxRemoteMessage)
+						- sizeof(RemoteReply);
+    bcopy(buffer, (char *) &reply, sizeof(RemoteReply));
+    block->length = max(0, min(reply.status, min(length, RemoteBlockSize)));
+    bcopy(buffer + sizeof(RemoteReply), block->data, block->length);
+    Confirm(block->file, &reply);
+    block->pending = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Confirm
+// 	Take in what a reply about "file" says: how long the file is on
+//	the server, and whether a write to it failed.  After a failure,
+//	drop the file's cached blocks, except those on their way -- the
+//	others may have been patched by writes the server didn't make.
+//	The caller holds the lock.
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::Confirm(RemoteFile *file, RemoteReply *reply)
+{
+    file->length = max(file->length, reply->fileLength);
+    if (reply->writeFailed && !file->writeFailed) {
+	DEBUG('n', "Remote file %d: a write failed\n", file->fileId);
+	file->writeFailed = TRUE;
+	writeErrors++;
+	for (int i = 0; i < RemoteCacheBlocks; i++)
+	    if (cache[i].file == file && !cache[i].pending)
+		cache[i].file = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::FindBlock
+// 	Return the cached block "blockNum" of "file", or NULL.  It may
+//	still be on its way.
+//----------------------------------------------------------------------
+
+RemoteBlock *
+RemoteFileSystem::FindBlock(RemoteFile *file, int blockNum)
+{
+    for (int i = 0; i < RemoteCacheBlocks; i++)
+	if (cache[i].file == file && cache[i].blockNum == blockNum)
+	    return &cache[i];
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::FetchBlock
+// 	Ask the server for block "blockNum" of "file", unless we have it
+//	already, in place of the least recently used block that isn't on
+//	its way.  Return the block, which is pending until its reply is
+//	received.
+//----------------------------------------------------------------------
+
+RemoteBlock *
+RemoteFileSystem::FetchBlock(RemoteFile *file, int blockNum)
+{
+    RemoteBlock *block = FindBlock(file, blockNum);
+    RemoteRequest request;
+
+    if (block != NULL)
+	return block;
+    for (int i = 0; i < RemoteCacheBlocks; i++) {
+	if (cache[i].pending)
+	    continue;
+	if (block == NULL || cache[i].file == NULL
+			|| (block->file != NULL
+			    && cache[i].lastUsed < block->lastUsed))
+	    block = &cache[i];
+    }
+    ASSERT(block != NULL);	// at most readAhead + 1 are pending
+
+    block->file = file;
+    block->blockNum = blockNum;
+    block->pending = TRUE;
+    block->length = 0;
+    block->lastUsed = ++useCount;
+
+    request.op = RemoteRead;
+    request.fileId = file->fileId;
+    request.position = blockNum * RemoteBlockSize;
+    request.length = RemoteBlockSize;
+    Request(&request, NULL, 0);
+    awaiting->Append((void *) block);
+    return block;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::GetBlock
+// 	Return block "blockNum" of "file", fetching it if it isn't
+//	cached.  If the file is being read in order, make sure the next
+//	few blocks are on their way too, so the reader finds them here.
+//	The caller holds the lock.
+//----------------------------------------------------------------------
+
+RemoteBlock *
+RemoteFileSystem::GetBlock(RemoteFile *file, int blockNum)
+{
+    RemoteBlock *block = FindBlock(file, blockNum);
+    int next;
+
+    if (block != NULL)
+	cacheHits++;
+    else {
+	cacheMisses++;
+	block = FetchBlock(file, blockNum);
+    }
+    block->lastUsed = ++useCount;	// not to be replaced by what follows
+
+    if (blockNum == file->nextBlock)
+	for (next = blockNum + 1; next <= blockNum + readAhead; next++) {
+	    if (next * RemoteBlockSize >= file->Extent())
+		break;
+	    if (FindBlock(file, next) == NULL) {
+		FetchBlock(file, next);
+		blocksAhead++;
+	    }
+	}
+    file->nextBlock = blockNum + 1;
+
+    while (block->pending)
+	ReceiveBlock();
+    return block;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Forget
+// 	Drop the cached blocks of a file that is being closed, once their
+//	replies are in.  The caller holds the lock.
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::Forget(RemoteFile *file)
+{
+    while (!awaiting->IsEmpty())
+	ReceiveBlock();
+    for (int i = 0; i < RemoteCacheBlocks; i++)
+	if (cache[i].file == file)
+	    cache[i].file = NULL;
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::RemoteFile
+// 	Initialize a file opened on the server.
+//
+//	"remote" -- the remote file system it is on
+//	"id" -- the server's number for it
+//	"fileLength" -- its length when it was opened
+//----------------------------------------------------------------------
+
+RemoteFile::RemoteFile(RemoteFileSystem *remote, int id, int fileLength)
+{
+    fs = remote;
+    fileId = id;
+    length = lengthSent = fileLength;
+    writeFailed = FALSE;
+    seekPosition = 0;
+    nextBlock = 0;
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::~RemoteFile
+// 	Drop the file's blocks from the cache, and close it on the server.
+//	The server's answer says whether the last of our writes were
+//	made; if not, it is counted in the file system's writeErrors.
+//----------------------------------------------------------------------
+
+RemoteFile::~RemoteFile()
+{
+    RemoteRequest request;
+    RemoteReply reply;
+
+    fs->lock->Acquire();
+    fs->Forget(this);
+    request.op = RemoteClose;
+    request.fileId = fileId;
+    request.position = request.length = 0;
+    fs->Call(&request, NULL, 0, &reply);
+    if (reply.status == 0)
+	fs->Confirm(this, &reply);
+    fs->lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::Seek
+// 	Change the current location within the open file -- the point at
+//	which the next Read or Write will start from.
+//----------------------------------------------------------------------
+
+void
+RemoteFile::Seek(int position)
+{
+    seekPosition = position;
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::Read, Write
+// 	Read/write a portion of the file, starting from seekPosition.
+//	Return the number of bytes actually read or written, and as a
+//	side effect, increment the current position within the file.
+//----------------------------------------------------------------------
+
+int
+RemoteFile::Read(char *into, int numBytes)
+{
+    int result = ReadAt(into, numBytes, seekPosition);
+
+    seekPosition += result;
+    return result;
+}
+
+int
+RemoteFile::Write(char *from, int numBytes)
+{
+    int result = WriteAt(from, numBytes, seekPosition);
+
+    seekPosition += result;
+    return result;
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::ReadAt
+// 	Read a portion of the file, block by block, from the cache.
+//	Our writes past the end of the file may not have been made yet, so
+//	the server's blocks, not the length we know of, say where the
+//	file ends.  Return the number of bytes actually read.
+//----------------------------------------------------------------------
+
+int
+RemoteFile::ReadAt(char *into, int numBytes, int position)
+{
+    RemoteBlock *block;
+    int done = 0, offset, n;
+
+    if (position < 0 || numBytes <= 0 || position >= Extent())
+	return 0;
+    if (position + numBytes > Extent())
+	numBytes = Extent() - position;
+
+    fs->lock->Acquire();
+    while (done < numBytes) {
+	block = fs->GetBlock(this, (position + done) / RemoteBlockSize);
+	offset = (position + done) % RemoteBlockSize;
+	n = min(numBytes - done, block->length - offset);
+	if (n <= 0)
+	    break;		// the file is shorter than we thought
+	bcopy(block->data + offset, into + done, n);
+	done += n;
+    }
+    fs->lock->Release();
+    return done;
+}
+
+//----------------------------------------------------------------------
+// RemoteFile::WriteAt
+// 	Write a portion of the file, block by block, without waiting
+//	for the server: the connection delivers the writes in order, ahead
+//	of any later request.  Cached copies of the blocks are updated,
+//	once they have arrived, but not lengthened -- a block the write
+//	goes past the end of is dropped, and read again if need be.
+//
+//	Return the number of bytes sent, or 0 once the server has
+//	reported that a write to the file failed.
+//----------------------------------------------------------------------
+
+int
+RemoteFile::WriteAt(char *from, int numBytes, int position)
+{
+    RemoteRequest request;
+    RemoteBlock *block;
+    int done = 0, offset, n;
+
+    if (position < 0 || numBytes <= 0)
+	return 0;
+
+    fs->lock->Acquire();
+    if (writeFailed) {
+	fs->lock->Release();
+	return 0;
+    }
+    while (done < numBytes) {
+	offset = (position + done) % RemoteBlockSize;
+	n = min(numBytes - done, RemoteBlockSize - offset);
+
+	request.op = RemoteWrite;
+	request.fileId = fileId;
+	request.position = position + done;
+	request.length = n;
+	fs->Request(&request, from + done, n);
+
+	block = fs->FindBlock(this, (position + done) / RemoteBlockSize);
+	if (block != NULL) {
+	    while (block->pending)
+		fs->ReceiveBlock();
+	    if (offset + n <= block->length)
+		bcopy(from + done, block->data + offset, n);
+	    else
+		block->file = NULL;	// not till the server has made it
+	}
+	done += n;
+    }
+    lengthSent = max(lengthSent, position + numBytes);
+    fs->lock->Release();
+    return numBytes;
+}
@@ -0,0 +1,197 @@
+// remotefs.h
+//	Data structures for using the file system of another Nachos over
+//	the network.
+//
+//	A FileServer, on the machine with the files, takes requests over a
+//	reliable Connection and carries them out with its FileSystem and
+//	OpenFiles.  On the other machine, a RemoteFileSystem and its
+//	RemoteFiles look like the local FileSystem and OpenFile.
+//
+//	The client keeps a cache of file blocks.  When a file is read in
+//	order, the next few blocks are asked for ahead of time, so the
+//	server is already sending them by the time they are needed.
+//	Writes are not answered: they are sent, and the caller goes on,
+//	relying on the connection to deliver them in order -- so a read
+//	sent after a write always sees it.  A write the server can't make
+//	in full is reported with its next reply about the file -- a read,
+//	or the close -- and from then on, writes to the file fail.  Until
+//	the server has answered, the client doesn't count on a write: the
+//	file's length, and its cached blocks, grow only as far as the
+//	server says the file goes.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REMOTEFS_H
+#define REMOTEFS_H
+
+#include "copyright.h"
+#include "transport.h"
+#include "filesys.h"
+#include "list.h"
+
+#define RemoteBlockSize		256	// unit of caching and read-ahead
+#define RemoteCacheBlocks	32	// blocks cached by a client
+#define RemoteReadAhead		4	// blocks asked for ahead of a reader
+#define MaxRemoteFiles		16	// files a server has open at once
+#define MaxRemoteName		128	// longest file name
+#define RemoteWindow		16	// window of the connection
+#define RemoteLinger		(2 * MaxTimeout)
+					// quiet time before letting go of
+					// the connection
+
+#define MaxRemoteMessage	(sizeof(RemoteRequest) + MaxRemoteName \
+					+ RemoteBlockSize)
+					// no request or reply is longer
+
+// Requests from a client
+
+enum RemoteOp { RemoteCreate, RemoteRemove, RemoteOpen, RemoteRead,
+		RemoteWrite, RemoteClose, RemoteUnmount };
+
+// The following class defines the header of a request, followed by the
+// file name (Create, Remove, Open) or the data (Write).
+
+class RemoteRequest {
+  public:
+    int op;			// RemoteOp
+    int fileId;			// the server's number for an open file
+    int position;		// where to read or write
+    int length;			// how much to read or write; for Create,
+				// the initial size
+};
+
+// The following class defines the header of a reply, followed by the
+// data for a Read.  Write and Unmount have no reply.
+
+class RemoteReply {
+  public:
+    int status;			// Create, Remove: TRUE or FALSE; Open: the
+				// file's number, or -1; Read: bytes read;
+				// Close: 0, or -1 if the file wasn't open
+    int fileLength;		// Open, Read, Close: the file's length
+    int writeFailed;		// Read, Close: TRUE if a write to the file
+				// fell short since the last reply about it
+};
+
+// The following class defines the server end.
+
+class FileServer {
+  public:
+    FileServer(NetworkAddress client, MailBoxAddress box);
+				// Serve the client at "client", over a
+				// connection between our mailboxes "box"
+    ~FileServer();		// Close any files left open
+
+    void Serve();		// Carry out requests until the client
+				// unmounts
+    int requests;		// statistics: requests carried out
+
+  private:
+    Connection *conn;
+    OpenFile *files[MaxRemoteFiles];	// open files, by number
+    bool writeFailed[MaxRemoteFiles];	// ... and whether a write to
+					// one has failed, not yet reported
+};
+
+class RemoteFile;
+
+// The following class defines one block in the client's cache.
+
+class RemoteBlock {
+  public:
+    RemoteFile *file;		// whose block this is, NULL if none
+    int blockNum;		// which block of the file
+    bool pending;		// it has been asked for, but the reply
+				// hasn't been received
+    int length;			// valid bytes in "data"
+    int lastUsed;		// for replacing the least recently used
+    char data[RemoteBlockSize];
+};
+
+// The following class defines the client end: the file system of the
+// server, as seen from here.
+
+class RemoteFileSystem {
+  public:
+    RemoteFileSystem(NetworkAddress server, MailBoxAddress box,
+		int ahead = RemoteReadAhead);
+				// Use the files of "server", over a
+				// connection between our mailboxes "box";
+				// read "ahead" blocks ahead
+    ~RemoteFileSystem();	// Tell the server we are done
+
+    bool Create(char *name, int initialSize);
+    bool Remove(char *name);
+    RemoteFile *Open(char *name);	// NULL if it can't be opened
+    void SetReadAhead(int blocks) { readAhead = blocks; }
+
+    int cacheHits, cacheMisses;	// statistics: blocks found in the cache,
+    int blocksAhead;		// ... not found, and read ahead,
+    int writeErrors;		// ... and files a write to failed
+
+  private:
+    friend class RemoteFile;
+
+    Connection *conn;
+    Lock *lock;			// one request at a time
+    int readAhead;		// blocks to read ahead of a reader
+    RemoteBlock *cache;		// the cached blocks
+    int useCount;		// time, for lastUsed
+    List *awaiting;		// blocks asked for, in order of the
+				// replies to come
+    char *buffer;		// for building requests and taking replies
+
+    int Call(RemoteRequest *request, char *data, int dataLength,
+		RemoteReply *reply);
+				// Send a request and wait for its reply
+    void Request(RemoteRequest *request, char *data, int dataLength);
+				// Send a request without waiting
+    void ReceiveBlock();	// Take in the reply for the oldest block
+				// asked for
+    void Confirm(RemoteFile *file, RemoteReply *reply);
+				// Take in what the server says of a file
+    RemoteBlock *FindBlock(RemoteFile *file, int blockNum);
+    RemoteBlock *FetchBlock(RemoteFile *file, int blockNum);
+				// Ask for a block, unless it is cached
+				// or on its way
+    RemoteBlock *GetBlock(RemoteFile *file, int blockNum);
+				// Return a block, waiting for it to
+				// arrive if need be
+    void Forget(RemoteFile *file);	// Drop a file's blocks
+};
+
+// The following class defines a file open on the server.
+
+class RemoteFile {
+  public:
+    RemoteFile(RemoteFileSystem *remote, int id, int fileLength);
+    ~RemoteFile();		// Close the file
+
+    void Seek(int position);
+    int Read(char *into, int numBytes);
+    int Write(char *from, int numBytes);
+    int ReadAt(char *into, int numBytes, int position);
+    int WriteAt(char *from, int numBytes, int position);
+    int Length() { return length; }
+    bool WriteFailed() { return writeFailed; }
+				// Has the server reported a failed write?
+
+  private:
+    friend class RemoteFileSystem;
+
+    RemoteFileSystem *fs;
+    int fileId;			// the server's number for the file
+    int length;			// as far as the server has told us
+    int lengthSent;		// ... or as far as our writes go, not yet
+				// confirmed
+    bool writeFailed;		// the server couldn't make a write
+    int seekPosition;
+    int nextBlock;		// block a sequential reader wants next
+
+    int Extent() { return max(length, lengthSent); }
+				// how far a read may find data
+};
+
+#endif // REMOTEFS_H
@@ -0,0 +1,514 @@
+// transport.cc
+//	Routines for reliable delivery of messages between two mailboxes:
+//	cutting them into segments, resending the segments that are lost,
+//	and putting the messages back together at the far end.
+//
+//	Two threads serve each connection: the receiver takes in the
+//	segments and acknowledgements mailed by the far end, and the
+//	timer resends the oldest segment when its timeout runs out.
+//	Sending is done by whichever thread has something to send.  It
+//	copies the segment with the connection's lock held, but mails it
+//	after letting go of the lock: the post office may keep it waiting
+//	for the network, and meanwhile the receiver must be able to take
+//	in acknowledgements -- or the timer would resend segments that
+//	have in fact got there, and the round trip times would include
+//	the wait.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "transport.h"
+#include "system.h"
+
+// The following class defines a message that has been put back
+// together, waiting to be received.
+
+class Message {
+  public:
+    Message(char *d, int l) { data = d; length = l; }
+
+    char *data;
+    int length;
+};
+
+//----------------------------------------------------------------------
+// ReceiverHelper, TimerHelper
+// 	Dummy functions because C++ can't indirectly invoke member functions.
+//	They are forked as the connection's receiver and timer threads.
+//
+//	"arg" -- pointer to the connection
+//----------------------------------------------------------------------
+
+static void ReceiverHelper(intptr_t arg)
+{ Connection *c = (Connection *) arg; c->ReceiveSegments(); }
+static void TimerHelper(intptr_t arg)
+{ Connection *c = (Connection *) arg; c->Retransmit(); }
+
+//----------------------------------------------------------------------
+// Connection::Connection
+// 	Set up one end of a connection, and start its threads.
+//
+//	"farAddr" -- the machine at the other end
+//	"localBox" -- where the far end mails us segments
+//	"farBox" -- where we mail segments to the far end
+//	"window" -- most segments in flight at once, in each direction
+//----------------------------------------------------------------------
+
+Connection::Connection(NetworkAddress farAddress, MailBoxAddress local,
+			MailBoxAddress far, int windowSize)
+{
+    Thread *t;
+    int i;
+
+    ASSERT((windowSize > 0) && (windowSize <= MaxWindow));
+    farAddr = farAddress;
+    localBox = local;
+    farBox = far;
+    window = windowSize;
+    sendLock = new Lock("connection send");
+    lock = new Lock("connection");
+    windowOpen = new Condition("window open");
+    pending = new Condition("segments pending");
+
+    sendSlots = new Segment[window];
+    sendBase = nextSeq = 0;
+    dupAcks = 0;
+    recover = 0;
+    timerStart = 0;
+    timeout = InitialTimeout;
+    smoothedRtt = rttVariance = 0;
+
+    recvSlots = new Segment[window];
+    for (i = 0; i < window; i++)
+	recvSlots[i].valid = FALSE;
+    recvNext = 0;
+    assemblySize = 4 * MaxSegmentSize;
+    assembly = new char[assemblySize];
+    assembled = 0;
+    messages = new SynchList;
+    lastHeard = stats->totalTicks;
+
+    segmentsSent = segmentsResent = acksSent = segmentsDropped = 0;
+
+    t = new Thread("transport receiver");
+    t->Fork(ReceiverHelper, (intptr_t) this);
+    t = new Thread("transport timer");
+    t->Fork(TimerHelper, (intptr_t) this);
+}
+
+//----------------------------------------------------------------------
+// Connection::Send
+// 	Cut a message into segments, and send them, waiting whenever the
+//	window is full.  Return once the last segment has been sent --
+//	not acknowledged; see Flush.
+//
+//	The connection's lock is let go while each segment is mailed,
+//	but "sendLock" is held throughout, so that another message can't
+//	take sequence numbers in the middle of this one.
+//
+//	"data" -- the message
+//	"length" -- its size, in bytes
+//----------------------------------------------------------------------
+
+void
+Connection::Send(char *data, int length)
+{
+    OutgoingSegment out;
+    Segment *seg;
+    int seq, size;
+
+    sendLock->Acquire();
+    do {
+	lock->Acquire();
+	while (nextSeq - sendBase >= window)
+	    windowOpen->Wait(lock);
+	size = min(length, (int) MaxSegmentSize);
+	seq = nextSeq++;
+	seg = &sendSlots[seq % window];
+	seg->flags = SegmentData | ((size == length) ? SegmentLast : 0);
+	seg->length = size;
+	seg->resent = FALSE;
+	bcopy(data, seg->data, size);
+	if (seq == sendBase) {		// start the timer
+	    timerStart = stats->totalTicks;
+	    pending->Signal(lock);
+	}
+	Transmit(seq, &out);
+	lock->Release();
+	SendSegment(&out);
+	data += size;
+	length -= size;
+    } while (length > 0);
+    sendLock->Release();
+}
+
+//----------------------------------------------------------------------
+// Connection::Receive
+// 	Wait for the next complete message from the far end.
+//
+//	"data" -- where to put the message
+//	"maxLength" -- how much room there is; the rest of a longer
+//		message is thrown away
+//
+//	Returns the length of the message.
+//----------------------------------------------------------------------
+
+int
+Connection::Receive(char *data, int maxLength)
+{
+    Message *message = (Message *) messages->Remove();
+    int length = message->length;
+
+    bcopy(message->data, data, min(length, maxLength));
+    delete [] message->data;
+    delete message;
+    return length;
+}
+
+//----------------------------------------------------------------------
+// Connection::Flush
+// 	Wait until the far end has acknowledged every segment we sent.
+//----------------------------------------------------------------------
+
+void
+Connection::Flush()
+{
+    lock->Acquire();
+    while (sendBase != nextSeq)
+	windowOpen->Wait(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Connection::Close
+// 	Wait until everything we sent has been acknowledged, and then
+//	until the far end has gone quiet.  Our acknowledgement of its
+//	last segments may have been lost, in which case it will resend
+//	them, and we must still be there to acknowledge them again.
+//
+//	"linger" -- how long the far end must be quiet, in ticks
+//----------------------------------------------------------------------
+
+void
+Connection::Close(int linger)
+{
+    int quietUntil;
+
+    Flush();
+    for (;;) {
+	lock->Acquire();
+	quietUntil = lastHeard + linger;
+	lock->Release();
+	if (stats->totalTicks >= quietUntil)
+	    break;
+	alarmClock->WaitUntil(quietUntil);
+    }
+}
+
+//----------------------------------------------------------------------
+// Connection::SendSegment
+// 	Put a segment in the mail to the far end.  Waits until the
+//	network can take it, so the connection's lock must not be held.
+//
+//	"out" -- the segment, as made by Transmit or MakeAck
+//----------------------------------------------------------------------
+
+void
+Connection::SendSegment(OutgoingSegment *out)
+{
+    char buffer[MaxMailSize];
+    PacketHeader outPktHdr;
+    MailHeader outMailHdr;
+
+    ASSERT(!lock->isHeldByCurrentThread());
+    outPktHdr.to = farAddr;
+    outMailHdr.to = farBox;
+    outMailHdr.from = localBox;
+    outMailHdr.length = sizeof(SegmentHeader) + out->length;
+    bcopy((char *) &out->segHdr, buffer, sizeof(SegmentHeader));
+    bcopy(out->data, buffer + sizeof(SegmentHeader), out->length);
+    postOffice->Send(outPktHdr, outMailHdr, buffer);
+}
+
+//----------------------------------------------------------------------
+// Connection::Transmit
+// 	Get one of the unacknowledged segments ready to send (or send
+//	again), along with the latest acknowledgement for the far end.
+//	The caller mails it with SendSegment, once it lets go of the lock.
+//
+//	"seq" -- the segment's sequence number
+//	"out" -- where to put a copy of the segment
+//----------------------------------------------------------------------
+
+void
+Connection::Transmit(int seq, OutgoingSegment *out)
+{
+    Segment *seg = &sendSlots[seq % window];
+
+    ASSERT((seq >= sendBase) && (seq < nextSeq));
+    out->segHdr.seq = seq;
+    out->segHdr.ack = recvNext;
+    out->segHdr.flags = seg->flags;
+    out->length = seg->length;
+    bcopy(seg->data, out->data, seg->length);
+    seg->sentAt = stats->totalTicks;
+    segmentsSent++;
+    DEBUG('n', "Transport sending segment %d, %d bytes%s\n", seq,
+		seg->length, seg->resent ? ", again" : "");
+}
+
+//----------------------------------------------------------------------
+// Connection::MakeAck
+// 	Get ready to tell the far end which segment we need next.
+//
+//	"duplicate" -- TRUE if the segment that arrived didn't help, so
+//		the far end may have to resend the one we need
+//	"out" -- where to put the acknowledgement
+//----------------------------------------------------------------------
+
+void
+Connection::MakeAck(bool duplicate, OutgoingSegment *out)
+{
+    out->segHdr.seq = nextSeq;
+    out->segHdr.ack = recvNext;
+    out->segHdr.flags = duplicate ? SegmentDupAck : 0;
+    out->length = 0;
+    acksSent++;
+}
+
+//----------------------------------------------------------------------
+// Connection::MeasureRtt
+// 	Fold a round trip time into the estimate, and set the
+//	retransmission timeout from it.
+//
+//	"rtt" -- ticks from sending a segment to its acknowledgement
+//----------------------------------------------------------------------
+
+void
+Connection::MeasureRtt(int rtt)
+{
+    int delta;
+
+    rtt = max(rtt, 1);
+    if (smoothedRtt == 0) {		// first measurement
+	smoothedRtt = rtt;
+	rttVariance = rtt / 2;
+    } else {
+	delta = rtt - smoothedRtt;
+	if (delta < 0)
+	    delta = -delta;
+	rttVariance += (delta - rttVariance) / 4;
+	smoothedRtt += (rtt - smoothedRtt) / 8;
+    }
+    SetTimeout();
+}
+
+//----------------------------------------------------------------------
+// Connection::SetTimeout
+// 	Set the retransmission timeout to the round trip time estimate
+//	plus four mean deviations, undoing any back-off.
+//----------------------------------------------------------------------
+
+void
+Connection::SetTimeout()
+{
+    if (smoothedRtt == 0)		// nothing measured yet
+	timeout = InitialTimeout;
+    else
+	timeout = smoothedRtt + 4 * rttVariance;
+    timeout = max(timeout, MinTimeout);
+    timeout = min(timeout, MaxTimeout);
+}
+
+//----------------------------------------------------------------------
+// Connection::Acknowledged
+// 	The far end has received every segment before "ack".  Free up
+//	the window, and resend what looks lost.
+//
+//	"ack" -- the next segment the far end needs
+//	"duplicate" -- TRUE if the far end got a segment past a hole
+//	"when" -- when the acknowledgement arrived
+//	"resend" -- where to put the segment to resend, if any
+//
+//	Returns TRUE if "resend" is to be mailed.
+//----------------------------------------------------------------------
+
+bool
+Connection::Acknowledged(int ack, bool duplicate, int when,
+						OutgoingSegment *resend)
+{
+    bool resent = FALSE;
+    int seq;
+
+    if ((ack > sendBase) && (ack <= nextSeq)) {
+	for (seq = sendBase; seq < ack; seq++)
+	    resent |= sendSlots[seq % window].resent;
+	if (!resent)			// otherwise, which copy is acked?
+	    MeasureRtt(when - sendSlots[(ack - 1) % window].sentAt);
+	sendBase = ack;
+	dupAcks = 0;
+	timerStart = stats->totalTicks;
+	windowOpen->Broadcast(lock);
+	if (sendBase < recover) {	// the resent segment filled one
+					// hole; this is the next one
+	    sendSlots[sendBase % window].resent = TRUE;
+	    segmentsResent++;
+	    Transmit(sendBase, resend);
+	    return TRUE;
+	}
+    } else if (duplicate && (ack == sendBase) && (sendBase != nextSeq)) {
+	if (++dupAcks == 3) {		// the segment after it got there
+	    sendSlots[sendBase % window].resent = TRUE;
+	    segmentsResent++;
+	    recover = nextSeq;
+	    Transmit(sendBase, resend);
+	    return TRUE;
+	}
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Connection::Arrived
+// 	A data segment has arrived.  Keep it if it is new and within the
+//	window, deliver the messages it completes, and acknowledge it.
+//
+//	"segHdr" -- the transport header
+//	"data", "length" -- the segment's data
+//	"ackOut" -- where to put the acknowledgement to send back
+//----------------------------------------------------------------------
+
+void
+Connection::Arrived(SegmentHeader *segHdr, char *data, int length,
+						OutgoingSegment *ackOut)
+{
+    int seq = segHdr->seq;
+    Segment *slot;
+    char *bigger;
+
+    if ((seq < recvNext) || (seq >= recvNext + window)
+		|| (length > (int) MaxSegmentSize)
+		|| recvSlots[seq % window].valid) {
+	segmentsDropped++;
+	MakeAck(TRUE, ackOut);
+	return;
+    }
+    slot = &recvSlots[seq % window];
+    slot->valid = TRUE;
+    slot->flags = segHdr->flags;
+    slot->length = length;
+    bcopy(data, slot->data, length);
+
+    if (seq != recvNext) {		// there is a hole before it
+	MakeAck(TRUE, ackOut);
+	return;
+    }
+    while (recvSlots[recvNext % window].valid) {
+	slot = &recvSlots[recvNext % window];
+	if (assembled + slot->length > assemblySize) {
+	    while (assembled + slot->length > assemblySize)
+		assemblySize *= 2;
+	    bigger = new char[assemblySize];
+	    bcopy(assembly, bigger, assembled);
+	    delete [] assembly;
+	    assembly = bigger;
+	}
+	bcopy(slot->data, assembly + assembled, slot->length);
+	assembled += slot->length;
+	slot->valid = FALSE;
+	recvNext++;
+	if (slot->flags & SegmentLast) {
+	    bigger = new char[assembled];
+	    bcopy(assembly, bigger, assembled);
+	    messages->Append((void *) new Message(bigger, assembled));
+	    assembled = 0;
+	}
+    }
+    MakeAck(FALSE, ackOut);
+}
+
+//----------------------------------------------------------------------
+// Connection::ReceiveSegments
+// 	Take in whatever the far end mails us: acknowledgements for the
+//	sending side, and data for the receiving side.  Never returns.
+//
+//	The time a segment arrived is noted before waiting for the lock,
+//	so that a round trip time doesn't include that wait.  What we
+//	have to send in return -- a segment to resend, an acknowledgement
+//	-- is mailed once we have let go of the lock.
+//----------------------------------------------------------------------
+
+void
+Connection::ReceiveSegments()
+{
+    PacketHeader inPktHdr;
+    MailHeader inMailHdr;
+    SegmentHeader segHdr;
+    char buffer[MaxMailSize];
+    OutgoingSegment resend, ackOut;
+    bool resending, isData;
+    int when;
+
+    for (;;) {
+	postOffice->Receive(localBox, &inPktHdr, &inMailHdr, buffer);
+	when = stats->totalTicks;
+	if ((inPktHdr.from != farAddr) || (inMailHdr.from != farBox)
+		|| (inMailHdr.length < sizeof(SegmentHeader)))
+	    continue;			// not for this connection
+	bcopy(buffer, (char *) &segHdr, sizeof(SegmentHeader));
+	isData = (segHdr.flags & SegmentData) != 0;
+
+	lock->Acquire();
+	lastHeard = when;
+	resending = Acknowledged(segHdr.ack,
+			(segHdr.flags & SegmentDupAck) != 0, when, &resend);
+	if (isData)
+	    Arrived(&segHdr, buffer + sizeof(SegmentHeader),
+			inMailHdr.length - sizeof(SegmentHeader), &ackOut);
+	lock->Release();
+
+	if (resending)
+	    SendSegment(&resend);
+	if (isData)
+	    SendSegment(&ackOut);
+    }
+}
+
+//----------------------------------------------------------------------
+// Connection::Retransmit
+// 	Sleep until the oldest unacknowledged segment's timeout runs
+//	out, and resend it, backing off the timeout.  Never returns.
+//----------------------------------------------------------------------
+
+void
+Connection::Retransmit()
+{
+    OutgoingSegment out;
+    int deadline;
+
+    lock->Acquire();
+    for (;;) {
+	while (sendBase == nextSeq)
+	    pending->Wait(lock);
+	deadline = timerStart + timeout;
+	if (stats->totalTicks < deadline) {
+	    lock->Release();
+	    alarmClock->WaitUntil(deadline);
+	    lock->Acquire();
+	    continue;			// it may have been acked meanwhile
+	}
+	DEBUG('n', "Transport timeout %d for segment %d\n", timeout, sendBase);
+	timeout = min(2 * timeout, MaxTimeout);
+	sendSlots[sendBase % window].resent = TRUE;
+	segmentsResent++;
+	dupAcks = 0;
+	recover = nextSeq;
+	Transmit(sendBase, &out);
+	timerStart = stats->totalTicks;
+	lock->Release();
+	SendSegment(&out);
+	lock->Acquire();
+    }
+}
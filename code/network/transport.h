@@ -0,0 +1,181 @@
+// transport.h
+//	Data structures for reliable, ordered delivery of messages of any
+//	size between two mailboxes, over the post office -- which can drop
+//	packets, and carries at most MaxMailSize bytes in each.
+//
+//	A message is cut into segments that fit in a piece of mail, each
+//	with a sequence number; the last segment of a message says so.
+//	The far end puts the segments back in order, holding on to those
+//	that arrive early, and tells us the sequence number of the next
+//	segment it is missing -- so an acknowledgement covers every
+//	segment before it, and a lost acknowledgement is made good by the
+//	next one.
+//
+//	Up to "window" segments can be in flight at once.  A timer thread
+//	resends the oldest unacknowledged segment when the retransmission
+//	timeout runs out, doubling the timeout each time until something
+//	new is acknowledged; the timeout itself follows the measured round
+//	trip time and its variance (except for resent segments, whose
+//	acknowledgement is ambiguous).
+//	A segment that the far end keeps acknowledging past -- three
+//	duplicate acknowledgements -- is resent right away, and so is
+//	each later hole that the acknowledgement of the resent segment
+//	uncovers.
+//
+//	Each end of a connection must be created with the same window,
+//	and the same pair of mailboxes, swapped.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "copyright.h"
+#include "post.h"
+#include "stats.h"
+#include "synch.h"
+#include "synchlist.h"
+
+// The following class defines the transport header, put in front of
+// the data of each segment, after the MailHeader.
+
+class SegmentHeader {
+  public:
+    int seq;			// Sequence number of this segment
+    int ack;			// Next sequence number the sender of this
+				// segment expects from us
+    int flags;			// SegmentData, SegmentLast, SegmentDupAck
+};
+
+#define SegmentData	0x1	// segment carries data; otherwise it is
+				// just an acknowledgement
+#define SegmentLast	0x2	// segment ends a message
+#define SegmentDupAck	0x4	// acknowledgement of a segment that was
+				// out of order, or a duplicate
+
+#define MaxSegmentSize	(MaxMailSize - sizeof(SegmentHeader))
+				// data in one segment
+#define MaxWindow	64	// most segments in flight at once
+
+// Retransmission timeouts, in ticks
+
+#define InitialTimeout	(20 * NetworkTime)
+#define MinTimeout	(4 * NetworkTime)
+#define MaxTimeout	(1000 * NetworkTime)
+
+// The following class defines one segment, as kept by the sender until
+// it is acknowledged, or by the receiver until the segments before it
+// have arrived.
+
+class Segment {
+  public:
+    bool valid;			// receiver: the segment has arrived
+    int flags;			// SegmentData, SegmentLast
+    int length;			// bytes of data
+    int sentAt;			// sender: when it was last sent
+    bool resent;		// sender: it was sent more than once
+    char data[MaxSegmentSize];
+};
+
+// The following class defines a segment ready to be mailed: a copy of
+// its header and data, made with the connection's lock held, so that
+// the lock can be let go while the post office sends it.
+
+class OutgoingSegment {
+  public:
+    SegmentHeader segHdr;	// the transport header
+    int length;			// bytes of data
+    char data[MaxSegmentSize];
+};
+
+// The following class defines one end of a reliable connection.
+
+class Connection {
+  public:
+    Connection(NetworkAddress farAddr, MailBoxAddress localBox,
+		MailBoxAddress farBox, int window);
+				// Start talking to "farBox" on machine
+				// "farAddr", from "localBox" on this one.
+				// Its threads run for as long as Nachos
+				// does, so it is never de-allocated
+
+    void Send(char *data, int length);
+				// Queue a message for delivery; wait only
+				// for room in the window
+    int Receive(char *data, int maxLength);
+				// Wait for the next message, copy up to
+				// "maxLength" bytes of it into "data", and
+				// return its length
+    void Flush();		// Wait until everything sent has been
+				// acknowledged
+    void Close(int linger);	// Flush, then keep acknowledging what
+				// the far end resends, until it has been
+				// quiet for "linger" ticks
+
+    void ReceiveSegments();	// Take in segments from the far end.
+				// Called internally, by the receiver thread
+    void Retransmit();		// Resend segments whose timeout has run
+				// out.  Called internally, by the timer
+				// thread
+
+    int segmentsSent;		// statistics: segments sent, including
+    int segmentsResent;		// ... those sent again,
+    int acksSent;		// ... pure acknowledgements sent,
+    int segmentsDropped;	// ... and segments received that were
+				// duplicates, or beyond the window
+
+  private:
+    NetworkAddress farAddr;	// the far end
+    MailBoxAddress localBox, farBox;
+    int window;			// most segments in flight at once
+    Lock *sendLock;		// one message at a time is cut into
+				// segments, so they are numbered in a row
+    Lock *lock;			// protects everything below
+    Condition *windowOpen;	// signalled when segments are acknowledged
+    Condition *pending;		// signalled when segments are outstanding
+
+    // Sending side
+    Segment *sendSlots;		// unacknowledged segments, by seq % window
+    int sendBase;		// oldest unacknowledged segment
+    int nextSeq;		// next sequence number to use
+    int dupAcks;		// duplicate acknowledgements of sendBase
+    int recover;		// nextSeq when we last resent sendBase;
+				// acknowledgements short of it show
+				// further losses
+    int timerStart;		// when the oldest segment's timeout began
+    int timeout;		// current retransmission timeout
+    int smoothedRtt;		// round trip time estimate, in ticks, or
+				// 0 if not measured yet
+    int rttVariance;		// ... and its mean deviation
+
+    // Receiving side
+    Segment *recvSlots;		// early segments, by seq % window
+    int recvNext;		// next segment to deliver
+    char *assembly;		// the message being put back together
+    int assembled;		// ... how much of it has arrived
+    int assemblySize;		// ... and how much room there is
+    SynchList *messages;	// complete messages, not yet received
+    int lastHeard;		// when the far end last sent us anything
+
+    void Transmit(int seq, OutgoingSegment *out);
+				// Get segment "seq" from sendSlots ready
+				// to send
+    void MakeAck(bool duplicate, OutgoingSegment *out);
+				// ... or a pure acknowledgement
+    void SendSegment(OutgoingSegment *out);
+				// Put a segment in the mail; called
+				// without the lock
+    bool Acknowledged(int ack, bool duplicate, int when,
+						OutgoingSegment *resend);
+				// Process an acknowledgement; return TRUE
+				// if a segment is to be resent
+    void Arrived(SegmentHeader *segHdr, char *data, int length,
+						OutgoingSegment *ackOut);
+				// Process a data segment
+    void MeasureRtt(int rtt);	// Update the timeout from a sample
+    void SetTimeout();		// ... or just undo its back-off
+};
+
+#endif // TRANSPORT_H
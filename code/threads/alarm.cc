@@ -0,0 +1,113 @@
+// alarm.cc
+//	Routines to put kernel threads to sleep until a given time.
+//
+//	Only one alarm interrupt matters at a time: the one for the
+//	first sleeping thread.  When a thread goes to sleep ahead of it,
+//	a new interrupt is scheduled; the old one stays pending, and is
+//	ignored when it fires, since it is no longer the one expected.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// AlarmHandler
+// 	Interrupt handler for the alarm.  Dummy function because C++
+//	does not allow a pointer to a member function.
+//
+//	"when" is the time the interrupt was scheduled for.
+//----------------------------------------------------------------------
+
+static void
+AlarmHandler(intptr_t when)
+{
+    alarmClock->WakeUp((int) when);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize the alarm clock, with no thread asleep.
+//----------------------------------------------------------------------
+
+Alarm::Alarm()
+{
+    sleepers = new List;
+    nextWakeUp = 0;
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+// 	De-allocate the alarm clock.  Threads still asleep are simply
+//	forgotten: Nachos is halting.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    delete sleepers;
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+// 	Put the current thread to sleep until simulated time reaches
+//	"when"; return at once if it already has.
+//
+//	Threads due at the same time wake up in the order they went to
+//	sleep.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int when)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (when > stats->totalTicks) {
+	DEBUG('t', "Thread \"%s\" sleeping until time %d\n",
+					currentThread->getName(), when);
+	sleepers->SortedInsert((void *) currentThread, when);
+	if ((nextWakeUp == 0) || (when < nextWakeUp)) {
+	    nextWakeUp = when;
+	    interrupt->Schedule(AlarmHandler, (intptr_t) when,
+					when - stats->totalTicks, AlarmInt);
+	}
+	currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::WakeUp
+// 	Make every thread whose time has come ready to run, and schedule
+//	an interrupt for the next one to wake up, if any.
+//
+//	"when" -- the time this interrupt was scheduled for; if it is not
+//		the one we expect, an earlier wake-up replaced it, and
+//		there is nothing to do.
+//----------------------------------------------------------------------
+
+void
+Alarm::WakeUp(int when)
+{
+    Thread *thread;
+    int due;
+
+    if (when != nextWakeUp)
+	return;
+
+    while (((thread = (Thread *) sleepers->SortedFront(&due)) != NULL) &&
+						(due <= stats->totalTicks)) {
+	sleepers->Remove();
+	scheduler->ReadyToRun(thread);
+    }
+
+    if (thread == NULL)
+	nextWakeUp = 0;
+    else {
+	nextWakeUp = due;
+	interrupt->Schedule(AlarmHandler, (intptr_t) due,
+					due - stats->totalTicks, AlarmInt);
+    }
+}
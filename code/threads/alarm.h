@@ -0,0 +1,43 @@
+// alarm.h
+//	Data structures for a kernel alarm clock: threads call
+//	Alarm::WaitUntil to sleep until simulated time reaches a given
+//	tick, instead of calling Yield in a loop, which burns CPU time
+//	and keeps the ready list busy.
+//
+//	The sleeping threads are kept in order of wake-up time, and an
+//	interrupt is scheduled for the earliest one.  So when no thread
+//	is ready, Interrupt::Idle skips the clock straight ahead to the
+//	next wake-up, as it does for any other device.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "list.h"
+
+// The following class defines the alarm clock.
+
+class Alarm {
+  public:
+    Alarm();			// Initialize the alarm; no one is asleep
+    ~Alarm();			// De-allocate the alarm
+
+    void WaitUntil(int when);	// Put the current thread to sleep until
+				// stats->totalTicks reaches "when"
+
+    void WakeUp(int when);	// Wake up the threads that are due.
+				// Called internally, by the interrupt
+				// scheduled for time "when"
+
+  private:
+    List *sleepers;		// sleeping threads, by wake-up time
+    int nextWakeUp;		// time of the interrupt scheduled for the
+				// first of them; 0 if there are none
+};
+
+#endif // ALARM_H
@@ -141,8 +141,8 @@ void
 List::Mapcar(VoidFunctionPtr func)
 {
     for (ListElement *ptr = first; ptr != NULL; ptr = ptr->next) {
-       DEBUG('l', "In mapcar, about to invoke %x(%x)\n", func, ptr->item);
-       (*func)((int)ptr->item);
+       DEBUG('l', "In mapcar, about to invoke %p(%p)\n", func, ptr->item);
+       (*func)((intptr_t)ptr->item);
     }
 }
 
@@ -167,8 +167,10 @@ List::IsEmpty()
 //      
 //	Allocate a ListElement to keep track of the item.
 //      If the list is empty, then this will be the only element.
-//	Otherwise, walk through the list, one element at a time,
-//	to find where the new item should be placed.
+//	If it goes at the end -- as it does when every item has the
+//	same key, the common case for a list of threads -- put it there
+//	straight away.  Otherwise, walk through the list, one element
+//	at a time, to find where the new item should be placed.
 //
 //	"item" is the thing to put on the list, it can be a pointer to 
 //		anything.
@@ -184,6 +186,9 @@ List::SortedInsert(void *item, int sortKey)
     if (IsEmpty()) {	// if list is empty, put
         first = element;
         last = element;
+    } else if (sortKey >= last->key) {	// item goes at end of list
+	last->next = element;
+	last = element;
     } else if (sortKey < first->key) {	
 		// item goes on front of list
 	element->next = first;
@@ -236,3 +241,84 @@ List::SortedRemove(int *keyPtr)
     return thing;
 }
 
+//----------------------------------------------------------------------
+// List::SortedFront
+//      Return the first "item" on a sorted list, leaving it there.
+//	Removing it and inserting it back would not do, since that
+//	moves it behind any other items with the same key.
+// 
+// Returns:
+//	Pointer to the first item, NULL if nothing on the list.
+//	Sets *keyPtr to the priority value of that item.
+//
+//	"keyPtr" is a pointer to the location in which to store the 
+//		priority of the item.
+//----------------------------------------------------------------------
+
+void *
+List::SortedFront(int *keyPtr)
+{
+    if (IsEmpty()) 
+	return NULL;
+
+    if (keyPtr != NULL)
+        *keyPtr = first->key;
+    return first->item;
+}
+
+//----------------------------------------------------------------------
+// List::SortedRequeueFirst
+//      Move the first item on a sorted list behind any other items
+//	with the same key -- just as removing it with SortedRemove, and
+//	putting it back with SortedInsert, would.  But there is no
+//	ListElement to free and allocate again.
+//----------------------------------------------------------------------
+
+void
+List::SortedRequeueFirst()
+{
+    ListElement *element = first;
+    ListElement *ptr;
+
+    if (IsEmpty() || (first->next == NULL) || (first->next->key > first->key))
+	return;				// it stays where it is
+
+    first = element->next;
+    for (ptr = first; (ptr->next != NULL) && (ptr->next->key <= element->key);
+							ptr = ptr->next)
+	;
+    element->next = ptr->next;
+    ptr->next = element;
+    if (element->next == NULL)
+	last = element;
+}
+
+//----------------------------------------------------------------------
+// List::RemoveItem
+//      Take "item" off the list, wherever it is.
+//
+// Returns:
+//	TRUE if the item was on the list, FALSE otherwise.
+//----------------------------------------------------------------------
+
+bool
+List::RemoveItem(void *item)
+{
+    ListElement *prev = NULL;
+    ListElement *ptr;
+
+    for (ptr = first; ptr != NULL; prev = ptr, ptr = ptr->next)
+	if (ptr->item == item)
+	    break;
+    if (ptr == NULL)
+	return FALSE;
+
+    if (prev == NULL)
+	first = ptr->next;
+    else
+	prev->next = ptr->next;
+    if (last == ptr)
+	last = prev;
+    delete ptr;
+    return TRUE;
+}
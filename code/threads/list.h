@@ -48,6 +48,8 @@ class List {
     void Prepend(void *item); 	// Put item at the beginning of the list
     void Append(void *item); 	// Put item at the end of the list
     void *Remove(); 	 	// Take item off the front of the list
+    bool RemoveItem(void *item);	// Take item off the list, wherever
+					// it is
 
     void Mapcar(VoidFunctionPtr func);	// Apply "func" to every element 
 					// on the list
@@ -57,6 +59,10 @@ class List {
     // Routines to put/get items on/off list in order (sorted by key)
     void SortedInsert(void *item, int sortKey);	// Put item into list
     void *SortedRemove(int *keyPtr); 	  	// Remove first item from list
+    void *SortedFront(int *keyPtr);		// Look at first item on list,
+						// without removing it
+    void SortedRequeueFirst();			// Move first item behind the
+						// others with the same key
 
   private:
     ListElement *first;  	// Head of the list, NULL if list is empty
@@ -8,21 +8,65 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -lv <log levels> -rs <random seed #>
+//		-rec <event log> -rep <event log> -sp -pt -ss -sj <file>
+//		-tr <trace file> -tc <trace file> <json file> -pi -st -sl -wq
+//		-s -ms -nf -ft -j -x <nachos file> -c <consoleIn> <consoleOut>
+//		-ck <time> <checkpoint file> -rx <checkpoint file>
 //		-f -cp <unix file> <nachos file>
-//		-p <nachos file> -r <nachos file> -l -D -t
+//		-p <nachos file> -r <nachos file> -l -D -t -dh
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
 //              -z
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
+//    -lv sets how much each subsystem logs, eg. "files=verbose,dirs=info"
+//	or just "info" (cf. utility.h); by default only errors
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -rec records console input, network arrivals and random numbers,
+//	with the time they happened, to <event log>
+//    -rep replays an <event log>, repeating the recorded run exactly
+//	(use the same flags as when it was recorded)
+//    -sp profiles contention for semaphores and locks: how often
+//	each (by name) was taken, waited for, and for how long, printed
+//	when Nachos halts
+//    -pt prints, for each thread as it finishes (and for the one that
+//	halts Nachos), its time spent running user code, running the
+//	kernel, ready to run, and blocked
+//    -ss schedules threads by stride scheduling, sharing the CPU in
+//	proportion to their tickets, instead of by priority
+//    -sj writes every statistic to <file>, as JSON, when Nachos halts
+//    -tr traces context switches, interrupts, disk requests, system
+//	calls and page faults into a ring buffer, written in binary to
+//	<trace file> when Nachos halts (see trace.h)
+//    -tc converts a <trace file> to Chrome's trace format (for
+//	chrome://tracing or Perfetto), in <json file>
 //    -z prints the copyright message
 //
+//  THREADS
+//    -pi tests priority inheritance on locks
+//    -st tests that stride scheduling shares the CPU by tickets
+//    -sl tests bounded synchronized lists, and moving items through
+//	them in batches
+//    -wq tests work queues at two priorities, flushing them and
+//	stopping their workers
+//
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -ms prints the user instruction mix (per opcode, branches, load
+//	stalls) when Nachos halts
+//    -nf turns off the fusion of common user instruction pairs (the
+//	results are the same, only slower to simulate)
+//    -ft tests the fusion of user instruction pairs, and that code run
+//	from translated blocks (-j) does just what the interpreter does
+//    -j runs user programs from blocks of instructions decoded ahead
+//	of time, instead of decoding each one as it is executed (again,
+//	only faster)
 //    -x runs a user program
+//    -ck saves a checkpoint of the running user program once simulated
+//	time reaches <time>
+//    -rx resumes a user program from a checkpoint (start Nachos with
+//	the same flags as the run that saved it)
 //    -c tests the console
 //
 //  FILESYS
@@ -32,12 +76,24 @@
 //    -r removes a Nachos file from the file system
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system 
-//    -t tests the performance of the Nachos file system
+//    -t tests the performance of the Nachos file system, and prints
+//	the host time it took
+//    -dh prints histograms of disk request times (queue wait, seek,
+//	rotation, transfer) and the track buffer hit rate when Nachos
+//	halts
 //
 //  NETWORK
-//    -n sets the network reliability
+//    -l sets the network reliability
 //    -m sets this machine's host id (needed for the network)
+//    -nb sets the network bandwidth, in bytes per 1000 ticks
+//    -nd sets the network delay, in ticks
+//    -nj sets the most random extra network delay (jitter), in ticks
+//    -nq sets how many packets can be queued to be sent
 //    -o runs a simple test of the Nachos network software
+//    -ot runs a test of reliable transport over the network
+//    -os serves this machine's files to a remote file system client
+//    -oc runs a test of a remote file system, using a -os server
+//    -ob runs a benchmark of network latency and throughput
 //
 //  NOTE -- flags are ignored until the relevant assignment.
 //  Some of the flags are interpreted here; some in system.cc.
@@ -56,10 +112,16 @@
 
 // External functions used by this file
 
-extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
+extern void ThreadTest(void), PriorityTest(void), StrideTest(void);
+extern void SynchListTest(void), WorkQueueTest(void);
+extern void Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
-extern void MailTest(int networkID);
+extern void RestoreProcess(char *checkpoint);
+extern void FuseTest();
+extern void MailTest(int networkID), TransportTest(int networkID);
+extern void FileServerTest(int networkID), RemoteFileTest(int networkID);
+extern void NetworkBenchmark(int networkID);
 
 // IFT320: new functions
 extern void DirectoryTest();
@@ -99,11 +161,32 @@ main(int argc, char **argv)
 	argCount = 1;
         if (!strcmp(*argv, "-z"))               // print copyright
             printf (copyright);
+        else if (!strcmp(*argv, "-tc")) {	// convert a trace
+	    ASSERT(argc > 2);
+	    TraceToJson(*(argv + 1), *(argv + 2));
+	    argCount = 3;
+	}
+#ifdef THREADS
+        if (!strcmp(*argv, "-pi"))		// test priority inheritance
+            PriorityTest();
+        else if (!strcmp(*argv, "-st"))	// test stride scheduling
+            StrideTest();
+        else if (!strcmp(*argv, "-sl"))	// test synchronized lists
+            SynchListTest();
+        else if (!strcmp(*argv, "-wq"))	// test work queues
+            WorkQueueTest();
+#endif
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-x")) {        	// run a user program
 	    ASSERT(argc > 1);
             StartProcess(*(argv + 1));
             argCount = 2;
+        } else if (!strcmp(*argv, "-rx")) {	// resume from a checkpoint
+	    ASSERT(argc > 1);
+            RestoreProcess(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-ft")) {	// test instruction fusion
+            FuseTest();
         } else if (!strcmp(*argv, "-c")) {      // test the console
 	    if (argc == 1)
 	        ConsoleTest(NULL, NULL);
@@ -156,6 +239,26 @@ main(int argc, char **argv)
 						// start up another nachos
             MailTest(atoi(*(argv + 1)));
             argCount = 2;
+        } else if (!strcmp(*argv, "-ot")) {
+	    ASSERT(argc > 1);
+            Delay(2); 				// as for -o
+            TransportTest(atoi(*(argv + 1)));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-os")) {
+	    ASSERT(argc > 1);
+            Delay(2); 				// as for -o
+            FileServerTest(atoi(*(argv + 1)));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-oc")) {
+	    ASSERT(argc > 1);
+            Delay(2); 				// as for -o
+            RemoteFileTest(atoi(*(argv + 1)));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-ob")) {
+	    ASSERT(argc > 1);
+            Delay(2); 				// as for -o
+            NetworkBenchmark(atoi(*(argv + 1)));
+            argCount = 2;
         }
 #endif // NETWORK
     }
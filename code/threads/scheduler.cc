@@ -11,8 +11,16 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	Simple implementation -- the ready thread with the highest
+//	priority runs first, straight FIFO among threads of the same
+//	priority.
+//
+//	Or, with stride scheduling, threads share the CPU in proportion
+//	to their tickets.  Each thread has a "pass", which advances by
+//	its stride (StrideOne / tickets) for every tick it runs, and the
+//	ready thread with the lowest pass runs first.  A thread that
+//	sleeps keeps its distance from the pass of the rest, so it does
+//	not come back owed all the time it was away.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -22,6 +30,9 @@
 #include "scheduler.h"
 #include "system.h"
 
+#define MaxPass		(1 << 30)	// passes are brought down past this
+#define MaxCharge	(1 << 28)	// the most a single run can cost
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads to empty.
@@ -30,6 +41,8 @@
 Scheduler::Scheduler()
 { 
     readyList = new List; 
+    policy = PriorityPolicy;
+    globalPass = 0;
 } 
 
 //----------------------------------------------------------------------
@@ -45,7 +58,9 @@ Scheduler::~Scheduler()
 //----------------------------------------------------------------------
 // Scheduler::ReadyToRun
 // 	Mark a thread as ready, but not running.
-//	Put it on the ready list, for later scheduling onto the CPU.
+//	Put it on the ready list, for later scheduling onto the CPU:
+//	behind the threads of the same priority, ahead of those of a
+//	lower one -- or by pass, with stride scheduling.
 //
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
@@ -53,10 +68,55 @@ Scheduler::~Scheduler()
 void
 Scheduler::ReadyToRun (Thread *thread)
 {
+    ThreadStatus oldStatus = thread->getStatus();
+
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
+    if (policy == StridePolicy) {
+	if (oldStatus == RUNNING)		// yielding
+	    Charge(thread);
+	else if (oldStatus == BLOCKED)		// back from sleep
+	    thread->pass += globalPass;
+	else					// new
+	    thread->pass = globalPass + thread->stride;
+    }
+    readyList->SortedInsert((void *)thread, SortKey(thread));
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Blocked
+// 	Note that the running thread has gone to sleep.  With stride
+//	scheduling, charge it for its run, then keep how far its pass
+//	is ahead of everybody else's (see ReadyToRun).
+//
+//	"thread" is the thread, now BLOCKED.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Blocked (Thread *thread)
+{
+    if (policy == StridePolicy) {
+	Charge(thread);
+	thread->pass -= globalPass;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Reprioritize
+// 	Move a thread on the ready list to its place for the priority
+//	it now has -- because it inherited a higher one, for instance.
+//
+//	"thread" is the thread, already on the ready list.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Reprioritize (Thread *thread)
+{
+    bool wasReady = readyList->RemoveItem((void *)thread);
+
+    ASSERT(wasReady);
+    readyList->SortedInsert((void *)thread, SortKey(thread));
 }
 
 //----------------------------------------------------------------------
@@ -70,7 +130,13 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
-    return (Thread *)readyList->Remove();
+    Thread *thread = (Thread *)readyList->Remove();
+
+    if ((thread != NULL) && (policy == StridePolicy)) {
+	globalPass = thread->pass;
+	thread->cpuAtDispatch = thread->CpuTicks();
+    }
+    return thread;
 }
 
 //----------------------------------------------------------------------
@@ -98,9 +164,11 @@ Scheduler::Run (Thread *nextThread)
 	currentThread->space->SaveState();
     }
 #endif
-    
-    oldThread->CheckOverflow();		    // check if the old thread
-					    // had an undetected stack overflow
+
+    // No need to check the old thread's stack for an overflow: its
+    // guard page would have stopped it (see StackOverflowHandler).
+
+    TRACE(TraceSwitch, nextThread->getTraceId());
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
@@ -134,6 +202,17 @@ Scheduler::Run (Thread *nextThread)
 #endif
 }
 
+//----------------------------------------------------------------------
+// Scheduler::IsEmpty
+// 	Return TRUE if no thread is waiting for the CPU.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::IsEmpty()
+{
+    return readyList->IsEmpty();
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
@@ -145,3 +224,79 @@ Scheduler::Print()
     printf("Ready list contents:\n");
     readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
 }
+
+//----------------------------------------------------------------------
+// Scheduler::SetPolicy
+// 	Change how the next thread to run is chosen, and put the ready
+//	threads in their order for the new policy.  When stride
+//	scheduling starts, everybody starts from the same pass.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetPolicy (SchedulingPolicy newPolicy)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    List *oldList = readyList;
+    Thread *thread;
+
+    readyList = new List;
+    policy = newPolicy;
+    globalPass = 0;
+    currentThread->pass = 0;
+    currentThread->cpuAtDispatch = currentThread->CpuTicks();
+    while ((thread = (Thread *)oldList->Remove()) != NULL) {
+	thread->pass = thread->stride;
+	readyList->SortedInsert((void *)thread, SortKey(thread));
+    }
+    delete oldList;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SortKey
+// 	Return the key that puts "thread" in its place on the ready list.
+//----------------------------------------------------------------------
+
+int
+Scheduler::SortKey (Thread *thread)
+{
+    if (policy == StridePolicy)
+	return thread->pass;
+    return -thread->getPriority();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Advance the pass of a thread that has stopped running, by its
+//	stride for each tick it ran since it was dispatched.
+//
+//	Passes only grow, so when they get large, we take the current
+//	global pass off every pass we hold -- the ready threads' and this
+//	one's.  Sleeping threads only hold the difference already.  The
+//	charge for one run is capped, so that a thread that ran a very
+//	long time without a switch cannot overflow its pass.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Charge (Thread *thread)
+{
+    long long charge = (long long) (thread->CpuTicks() - thread->cpuAtDispatch)
+							* thread->stride;
+    List *oldList;
+    Thread *ready;
+
+    thread->pass += (int) ((charge < MaxCharge) ? charge : MaxCharge);
+    if (thread->pass < MaxPass)
+	return;
+
+    DEBUG('t', "Taking %d off every thread's pass\n", globalPass);
+    thread->pass -= globalPass;
+    oldList = readyList;
+    readyList = new List;
+    while ((ready = (Thread *)oldList->Remove()) != NULL) {
+	ready->pass -= globalPass;
+	readyList->SortedInsert((void *)ready, ready->pass);
+    }
+    delete oldList;
+    globalPass = 0;
+}
@@ -13,6 +13,12 @@
 #include "list.h"
 #include "thread.h"
 
+// How the scheduler chooses the next thread to run: the ready thread
+// with the highest priority, or, with stride scheduling, the one with
+// the lowest pass -- the one that has had least CPU time for its
+// tickets (see Thread::setTickets).
+enum SchedulingPolicy { PriorityPolicy, StridePolicy };
+
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
@@ -23,14 +29,26 @@ class Scheduler {
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
+    void Reprioritize(Thread* thread);	// Ready thread's priority changed
+    void Blocked(Thread* thread);	// Running thread went to sleep
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+    bool IsEmpty();			// Are there no threads ready to run?
+    void SetPolicy(SchedulingPolicy newPolicy);
+					// Change how threads are chosen
     
   private:
     List *readyList;  		// queue of threads that are ready to run,
-				// but not running
+				// but not running, highest priority (or
+				// lowest pass) first
+    SchedulingPolicy policy;	// how we choose
+    int globalPass;		// pass of the last thread dispatched, for
+				// stride scheduling
+
+    int SortKey(Thread *thread);	// Where thread goes on readyList
+    void Charge(Thread *thread);	// Advance its pass for its last run
 };
 
 #endif // SCHEDULER_H
@@ -10,6 +10,7 @@
  *	    SUN SPARC
  *	    HP PA-RISC
  *	    Intel 386
+ *	    AMD64 (x86-64)
  *
  * We define two routines for each architecture:
  *
@@ -304,7 +305,7 @@ ThreadRoot:
         call    *InitialPC
         call    *WhenDonePC
 
-        # NOT REACHED
+        /* NOT REACHED */
         movl    %ebp,%esp
         popl    %ebp
         ret
@@ -358,3 +359,74 @@ SWITCH:
         ret
 
 #endif
+
+#ifdef HOST_x86_64
+
+        .text
+        .align  16
+
+        .globl  ThreadRoot
+
+/* void ThreadRoot( void )
+**
+** expects the following registers to be initialized:
+**      r15     points to startup function (interrupt enable)
+**      r13     contains inital argument to thread function
+**      r12     points to thread function
+**      r14     point to Thread::Finish()
+**
+** These are all callee-saved registers in the x86-64 ABI, so they
+** survive the calls below.  SWITCH leaves %rsp 8 bytes off a 16-byte
+** boundary; pushing %rbp realigns it before we call out.
+*/
+ThreadRoot:
+        pushq   %rbp
+        movq    %rsp,%rbp
+        call    *StartupPC
+        movq    InitialArg,%rdi
+        call    *InitialPC
+        call    *WhenDonePC
+
+        /* NOT REACHED */
+        movq    %rbp,%rsp
+        popq    %rbp
+        ret
+
+
+
+/* void SWITCH( thread *t1, thread *t2 )
+**
+** on entry, t1 is in rdi and t2 is in rsi, and the stack looks like:
+**       (rsp)  ->              return address
+**
+** Only the registers the x86-64 ABI makes callee-saved need to
+** survive the call, so those (plus the stack pointer and the return
+** address) are all we save and restore.
+*/
+        .globl  SWITCH
+SWITCH:
+        movq    %rbx,_RBX(%rdi)         # save registers
+        movq    %rbp,_RBP(%rdi)
+        movq    %r12,_R12(%rdi)
+        movq    %r13,_R13(%rdi)
+        movq    %r14,_R14(%rdi)
+        movq    %r15,_R15(%rdi)
+        movq    %rsp,_RSP(%rdi)         # save stack pointer
+        movq    0(%rsp),%rax            # get return address from stack
+        movq    %rax,_PC(%rdi)          # save it into the pc storage
+
+        movq    _RBX(%rsi),%rbx         # restore old registers
+        movq    _RBP(%rsi),%rbp
+        movq    _R12(%rsi),%r12
+        movq    _R13(%rsi),%r13
+        movq    _R14(%rsi),%r14
+        movq    _R15(%rsi),%r15
+        movq    _RSP(%rsi),%rsp         # restore stack pointer
+        movq    _PC(%rsi),%rax          # restore return address into rax
+        movq    %rax,0(%rsp)            # copy over the ret address on the stack
+
+        ret
+
+        .section .note.GNU-stack,"",@progbits
+
+#endif
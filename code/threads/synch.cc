@@ -38,6 +38,8 @@ Semaphore::Semaphore(char* debugName, int initialValue)
     name = debugName;
     value = initialValue;
     queue = new List;
+    profile = (synchProfiler != NULL) ?
+		synchProfiler->Find(debugName, SemaphoreKind) : NULL;
 }
 
 //----------------------------------------------------------------------
@@ -65,13 +67,18 @@ void
 Semaphore::P()
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+    int start = stats->totalTicks;
+    bool waited = FALSE;
     
     while (value == 0) { 			// semaphore not available
 	queue->Append((void *)currentThread);	// so go to sleep
 	currentThread->Sleep();
+	waited = TRUE;
     } 
     value--; 					// semaphore available, 
 						// consume its value
+    if (profile != NULL)
+	profile->Acquired(waited, stats->totalTicks - start);
     
     (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
@@ -97,13 +104,11 @@ Semaphore::V()
     (void) interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
-
 //+++++++++++++++++++++++++++++++++++++
 //  Implantation des verrous pour les besoins du tp du systeme de fichier
 //	
+bool priorityInheritance = TRUE;
+
 //+++++++++++++++++++++++++++++++++++++
 //
 // Lock::Lock
@@ -117,6 +122,9 @@ Lock::Lock(char* debugName)
 	name = debugName;
 	state = NULL;			// etat du verrou-- non occupe au depart
 	queue = new List; 	// Les des threads en attente sur le verrou
+	nextHeld = NULL;
+	profile = (synchProfiler != NULL) ?
+			synchProfiler->Find(debugName, LockKind) : NULL;
 }
 //+++++++++++++++++++++++++++++++++++++
 //
@@ -133,19 +141,29 @@ Lock::~Lock()
 //
 // Lock::Acquire
 //        Semande le verrou. Si le verrou est detenu par un autre thread, le
-//			 demandeur est mis en attent.
+//			 demandeur est mis en attent, a son rang de priorite, et le
+//			 detenteur herite de sa priorite si elle est plus haute.
 //
 //++++++++++++++++++++++++++++++++++
 
 void Lock::Acquire() 
 {
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);
-	if (state != NULL)
+	int start = stats->totalTicks;
+	bool waited = (state != NULL);
+	if (waited)
 	{
-		queue->Append((void*) currentThread);
-		currentThread->Sleep();
+		currentThread->waitingFor = this;
+		queue->SortedInsert((void*) currentThread,
+					-currentThread->getPriority());
+		((Thread *) state)->RecomputePriority();
+		currentThread->Sleep();		// Release nous donne le verrou
 	}
-	state = currentThread;
+	else
+		GiveTo(currentThread);
+	heldSince = stats->totalTicks;
+	if (profile != NULL)
+		profile->Acquired(waited, heldSince - start);
 	(void) interrupt->SetLevel(oldLevel);
 }
 
@@ -153,27 +171,185 @@ void Lock::Acquire()
 //
 // Lock::Release
 //        Relache le verrou si le demandeur est bien celui qui le detient.
-//			 Assigne le verrou au prochain thread ou le met a libre.
+//			 Assigne le verrou au prochain thread (le plus prioritaire)
+//			 ou le met a libre.  Le demandeur retrouve la priorite qu'il
+//			 avait avant d'heriter de celles des threads en attente, et
+//			 cede le processeur si le nouveau detenteur passe avant lui
+//			 (sauf si les interruptions etaient deja desactivees).
 //
 //++++++++++++++++++++++++++++++++++
 void Lock::Release() 
 {
 	Thread * thread;
+	Lock ** ptr;
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);
 	if (!(state == (void*) currentThread))
 	{
 		printf("Erreur, le verrou n'appartient pas a l'appelant...\n");
 		ASSERT(FALSE);
 	}
+	for (ptr = &currentThread->locksHeld; *ptr != this;
+						ptr = &(*ptr)->nextHeld)
+		ASSERT(*ptr != NULL);
+	*ptr = nextHeld;
+	if (profile != NULL)
+		profile->Released(stats->totalTicks - heldSince);
 	thread = (Thread *) queue->Remove();
+	GiveTo(thread);
 	if (thread != NULL)
+	{
+		thread->RecomputePriority();	// herite des suivants
 		scheduler->ReadyToRun(thread);
-	state = thread;
+	}
+	currentThread->RecomputePriority();
 	(void) interrupt->SetLevel(oldLevel);
+	if ((oldLevel == IntOn) && (thread != NULL) &&
+			(thread->getPriority() > currentThread->getPriority()))
+		currentThread->Yield();		// pas dans Condition::Wait
+}
+
+//+++++++++++++++++++++++++++++++++++++
+//
+// Lock::isHeldByCurrentThread
+//        Vrai si le verrou appartient au thread courant.
+//
+//++++++++++++++++++++++++++++++++++
+bool Lock::isHeldByCurrentThread()
+{
+	return state == (void*) currentThread;
+}
+
+//+++++++++++++++++++++++++++++++++++++
+//
+// Lock::GiveTo
+//        Donne le verrou a "thread" (ou le met a libre si NULL), et
+//			 l'ajoute aux verrous que ce thread detient.
+//
+//++++++++++++++++++++++++++++++++++
+void Lock::GiveTo(Thread *thread)
+{
+	state = thread;
+	if (thread != NULL)
+	{
+		thread->waitingFor = NULL;
+		nextHeld = thread->locksHeld;
+		thread->locksHeld = this;
+	}
 }
 
-Condition::Condition(char* debugName) { }
-Condition::~Condition() { }
-void Condition::Wait(Lock* conditionLock) { ASSERT(FALSE); }
-void Condition::Signal(Lock* conditionLock) { }
-void Condition::Broadcast(Lock* conditionLock) { }
+//+++++++++++++++++++++++++++++++++++++
+//
+// Lock::Requeue
+//        La priorite de "thread", en attente du verrou, a change: le
+//			 remet a son rang, et le detenteur en herite s'il y a lieu.
+//
+//++++++++++++++++++++++++++++++++++
+void Lock::Requeue(Thread *thread)
+{
+	bool wasWaiting = queue->RemoveItem((void*) thread);
+
+	ASSERT(wasWaiting);
+	queue->SortedInsert((void*) thread, -thread->getPriority());
+	((Thread *) state)->RecomputePriority();
+}
+
+//+++++++++++++++++++++++++++++++++++++
+//
+// Lock::HighestWaiter
+//        Met dans *priorityPtr la priorite du premier thread en attente.
+//			 Retourne FALSE s'il n'y en a pas.
+//
+//++++++++++++++++++++++++++++++++++
+bool Lock::HighestWaiter(int *priorityPtr)
+{
+	int key;
+
+	if (queue->SortedFront(&key) == NULL)
+		return FALSE;
+	*priorityPtr = -key;
+	return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Condition::Condition
+// 	Initialize a condition variable, with no one waiting on it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Condition::Condition(char* debugName)
+{
+    name = debugName;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Condition::~Condition
+// 	De-allocate a condition variable.  Assume no one is still
+//	waiting on it!
+//----------------------------------------------------------------------
+
+Condition::~Condition()
+{
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Condition::Wait
+// 	Release the lock, wait until signaled, then re-acquire the lock.
+//	Releasing the lock and going to sleep must be done atomically,
+//	or a Signal could slip in between and be lost, so interrupts
+//	stay disabled until we are asleep.
+//
+//	Mesa semantics: by the time we have the lock back, some other
+//	thread may have changed the state we were waiting for, so the
+//	caller must check it again.
+//----------------------------------------------------------------------
+
+void
+Condition::Wait(Lock* conditionLock)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    queue->Append((void *)currentThread);
+    conditionLock->Release();
+    currentThread->Sleep();
+    (void) interrupt->SetLevel(oldLevel);
+    conditionLock->Acquire();
+}
+
+//----------------------------------------------------------------------
+// Condition::Signal
+// 	Wake up one thread waiting on the condition, if any.
+//----------------------------------------------------------------------
+
+void
+Condition::Signal(Lock* conditionLock)
+{
+    Thread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    thread = (Thread *)queue->Remove();
+    if (thread != NULL)
+	scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Condition::Broadcast
+// 	Wake up every thread waiting on the condition.
+//----------------------------------------------------------------------
+
+void
+Condition::Broadcast(Lock* conditionLock)
+{
+    Thread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    while ((thread = (Thread *)queue->Remove()) != NULL)
+	scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
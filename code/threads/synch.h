@@ -20,6 +20,7 @@
 #include "copyright.h"
 #include "thread.h"
 #include "list.h"
+#include "synchprof.h"
 
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
@@ -49,6 +50,8 @@ class Semaphore {
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
     List *queue;       // threads waiting in P() for the value to be > 0
+    SynchRecord *profile;	// contention statistics, NULL unless
+				// profiling (see synchprof.h)
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -62,6 +65,17 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// Waiting threads get the lock in order of priority.  And while a
+// thread waits for a lock, the holder runs at the waiter's priority,
+// if that is higher than its own -- passing it on in turn to the
+// holder of any lock it waits for itself.  Otherwise, threads of
+// medium priority could keep the holder, and so the waiter, from
+// running indefinitely ("priority inversion").  Turn off
+// "priorityInheritance" to see that happen.
+
+extern bool priorityInheritance;	// Do lock holders inherit the
+					// priority of their waiters?
 
 class Lock {
   public:
@@ -84,7 +98,20 @@ class Lock {
     // variables pour l'etat et la file d'attente
     
     void* state;			// etat du verrou
-    List* queue;			// liste d'attente pour le verrou
+    List* queue;			// liste d'attente pour le verrou,
+					// par ordre de priorite
+    Lock* nextHeld;			// verrou suivant detenu par le
+					// meme thread (Thread::locksHeld)
+    SynchRecord* profile;		// statistiques de contention, NULL
+					// sauf avec -sp (synchprof.h)
+    int heldSince;			// depuis quand il est detenu
+
+    void GiveTo(Thread *thread);	// donne le verrou a "thread"
+    void Requeue(Thread *thread);	// la priorite d'un thread en
+					// attente a change
+    bool HighestWaiter(int *priorityPtr);
+					// priorite du premier en attente
+    friend class Thread;
 };
 
 // The following class defines a "condition variable".  A condition
@@ -136,6 +163,6 @@ class Condition {
 
   private:
     char* name;
-    // plus some other stuff you'll need to define
+    List *queue;			// threads waiting in Wait()
 };
 #endif // SYNCH_H
@@ -20,13 +20,31 @@
 //	Allocate and initialize the data structures needed for a 
 //	synchronized list, empty to start with.
 //	Elements can now be added to the list.
+//
+//	"maxItems" -- if given, how many items the list may hold before
+//		Append has to wait
 //----------------------------------------------------------------------
 
 SynchList::SynchList()
+{
+    Init(0);
+}
+
+SynchList::SynchList(int maxItems)
+{
+    ASSERT(maxItems > 0);
+    Init(maxItems);
+}
+
+void
+SynchList::Init(int maxItems)
 {
     list = new List();
+    numItems = 0;
+    capacity = maxItems;
     lock = new Lock("list lock"); 
     listEmpty = new Condition("list empty cond");
+    listFull = new Condition("list full cond");
 }
 
 //----------------------------------------------------------------------
@@ -39,12 +57,14 @@ SynchList::~SynchList()
     delete list; 
     delete lock;
     delete listEmpty;
+    delete listFull;
 }
 
 //----------------------------------------------------------------------
 // SynchList::Append
-//      Append an "item" to the end of the list.  Wake up anyone
-//	waiting for an element to be appended.
+//      Append an "item" to the end of the list, first waiting for
+//	room if the list is full.  Wake up anyone waiting for an
+//	element to be appended.
 //
 //	"item" is the thing to put on the list, it can be a pointer to 
 //		anything.
@@ -54,7 +74,10 @@ void
 SynchList::Append(void *item)
 {
     lock->Acquire();		// enforce mutual exclusive access to the list 
+    while (IsFull())
+	listFull->Wait(lock);	// wait until there is room
     list->Append(item);
+    numItems++;
     listEmpty->Signal(lock);	// wake up a waiter, if any
     lock->Release();
 }
@@ -77,10 +100,70 @@ SynchList::Remove()
 	listEmpty->Wait(lock);		// wait until list isn't empty
     item = list->Remove();
     ASSERT(item != NULL);
+    numItems--;
+    listFull->Signal(lock);		// wake up a waiting producer, if any
     lock->Release();
     return item;
 }
 
+//----------------------------------------------------------------------
+// SynchList::AppendMany
+//      Append "howMany" items to the end of the list, in order, with
+//	one acquisition of the lock -- except that, if the list fills
+//	up, we must wait for room, letting consumers in.  Wake up
+//	anyone waiting for an element to be appended.
+//
+//	"items" -- the things to put on the list
+//	"howMany" -- how many of them there are
+//----------------------------------------------------------------------
+
+void
+SynchList::AppendMany(void **items, int howMany)
+{
+    int i = 0;
+
+    lock->Acquire();
+    while (i < howMany) {
+	while (IsFull())
+	    listFull->Wait(lock);
+	for (; (i < howMany) && !IsFull(); i++) {
+	    list->Append(items[i]);
+	    numItems++;
+	}
+	listEmpty->Broadcast(lock);	// there may be enough for several
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchList::RemoveUpTo
+//      Remove up to "howMany" items from the beginning of the list,
+//	with one acquisition of the lock.  Wait if the list is empty,
+//	but once there is something on it, take whatever there is.
+//
+//	"items" -- where to put the removed items, in order
+//	"howMany" -- the most to remove
+// Returns:
+//	How many items were removed: at least one, at most "howMany".
+//----------------------------------------------------------------------
+
+int
+SynchList::RemoveUpTo(void **items, int howMany)
+{
+    int removed;
+
+    ASSERT(howMany > 0);
+    lock->Acquire();
+    while (list->IsEmpty())
+	listEmpty->Wait(lock);
+    for (removed = 0; (removed < howMany) && !list->IsEmpty(); removed++)
+	items[removed] = list->Remove();
+    numItems -= removed;
+    listFull->Broadcast(lock);		// there may be room for several
+    lock->Release();
+    return removed;
+}
+
 //----------------------------------------------------------------------
 // SynchList::Mapcar
 //      Apply function to every item on the list.  Obey mutual exclusion
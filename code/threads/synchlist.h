@@ -20,23 +20,45 @@
 //	1. Threads trying to remove an item from a list will
 //	wait until the list has an element on it.
 //	2. One thread at a time can access list data structures
+//	3. If the list is bounded, threads trying to append an item
+//	wait until there is room for it, so that a producer can't get
+//	arbitrarily far ahead of its consumers.
+//
+// AppendMany and RemoveUpTo move a batch of items for a single
+// acquisition of the lock.
 
 class SynchList {
   public:
-    SynchList();		// initialize a synchronized list
+    SynchList();		// initialize an unbounded synchronized list
+    SynchList(int maxItems);	// ... or one holding at most maxItems
     ~SynchList();		// de-allocate a synchronized list
 
     void Append(void *item);	// append item to the end of the list,
-				// and wake up any thread waiting in remove
+				// waiting if the list is full, and wake
+				// up any thread waiting in remove
     void *Remove();		// remove the first item from the front of
 				// the list, waiting if the list is empty
+    void AppendMany(void **items, int howMany);
+				// append "howMany" items, in order, waiting
+				// for room as need be
+    int RemoveUpTo(void **items, int howMany);
+				// remove as many items as there are, up to
+				// "howMany", waiting if the list is empty;
+				// return how many were removed
 				// apply function to every item in the list
     void Mapcar(VoidFunctionPtr func);
 
   private:
     List *list;			// the unsynchronized list
+    int numItems;		// how many items are on it
+    int capacity;		// ... and how many it may hold, 0 if there
+				// is no limit
     Lock *lock;			// enforce mutual exclusive access to the list
     Condition *listEmpty;	// wait in Remove if the list is empty
+    Condition *listFull;	// wait in Append if the list is full
+
+    void Init(int maxItems);	// initialize, for the constructors
+    bool IsFull() { return (capacity > 0) && (numItems >= capacity); }
 };
 
 #endif // SYNCHLIST_H
@@ -0,0 +1,207 @@
+// synchprof.cc
+//	Routines to profile contention for semaphores and locks.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchprof.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// SynchRecord::SynchRecord
+// 	Initialize the record for synchronization objects called
+//	"debugName"; nothing has happened to them yet.
+//----------------------------------------------------------------------
+
+SynchRecord::SynchRecord(char *debugName, SynchKind whichKind)
+{
+    name = new char[strlen(debugName) + 1];	// the object's copy may
+    strcpy(name, debugName);			// not outlive it
+    kind = whichKind;
+    numObjects = 0;
+    acquisitions = contended = 0;
+    totalWait = maxWait = 0;
+    releases = 0;
+    totalHold = maxHold = 0;
+    next = NULL;
+}
+
+SynchRecord::~SynchRecord()
+{
+    delete [] name;
+}
+
+//----------------------------------------------------------------------
+// SynchRecord::Acquired
+// 	Count one more P or Acquire.
+//
+//	"waited" -- did the thread have to wait?
+//	"ticks" -- if so, for how long
+//----------------------------------------------------------------------
+
+void
+SynchRecord::Acquired(bool waited, int ticks)
+{
+    acquisitions++;
+    if (waited) {
+	contended++;
+	totalWait += ticks;
+	if (ticks > maxWait)
+	    maxWait = ticks;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchRecord::Released
+// 	Count one more Release of a lock held for "ticks".
+//----------------------------------------------------------------------
+
+void
+SynchRecord::Released(int ticks)
+{
+    releases++;
+    totalHold += ticks;
+    if (ticks > maxHold)
+	maxHold = ticks;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::SynchProfiler
+// 	Initialize the profiler; no object has been profiled yet.
+//----------------------------------------------------------------------
+
+SynchProfiler::SynchProfiler()
+{
+    records = NULL;
+    numRecords = 0;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::~SynchProfiler
+// 	De-allocate the records.  The objects using them must be gone,
+//	or at least no longer used: Nachos is halting.
+//----------------------------------------------------------------------
+
+SynchProfiler::~SynchProfiler()
+{
+    SynchRecord *record;
+
+    while (records != NULL) {
+	record = records;
+	records = record->next;
+	delete record;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::Find
+// 	Return the record for a new synchronization object.  This is
+//	only done once per object, when it is created, so a walk through
+//	the records will do.
+//
+//	"name" -- the debug name of the object
+//	"kind" -- whether it is a semaphore or a lock
+//----------------------------------------------------------------------
+
+SynchRecord *
+SynchProfiler::Find(char *name, SynchKind kind)
+{
+    SynchRecord *record;
+
+    if (name == NULL)
+	name = "(no name)";
+    for (record = records; record != NULL; record = record->next)
+	if ((record->kind == kind) && !strcmp(record->name, name))
+	    break;
+    if (record == NULL) {
+	record = new SynchRecord(name, kind);
+	record->next = records;
+	records = record;
+	numRecords++;
+    }
+    record->numObjects++;
+    return record;
+}
+
+//----------------------------------------------------------------------
+// PrintsBefore
+// 	Should record r1 be printed before r2?  Most total wait first,
+//	then most contended, then by name.
+//----------------------------------------------------------------------
+
+static bool
+PrintsBefore(SynchRecord *r1, SynchRecord *r2)
+{
+    if (r1->totalWait != r2->totalWait)
+	return r1->totalWait > r2->totalWait;
+    if (r1->contended != r2->contended)
+	return r1->contended > r2->contended;
+    return strcmp(r1->name, r2->name) < 0;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::Print
+// 	Print a line per record, the worst bottleneck first.  Waits and
+//	holds are in simulated ticks; hold times only make sense for locks.
+//----------------------------------------------------------------------
+
+void
+SynchProfiler::Print()
+{
+    SynchRecord **sorted = new SynchRecord *[numRecords + 1];
+    SynchRecord *record;
+    int i, j;
+
+    for (i = 0, record = records; record != NULL; i++, record = record->next) {
+	for (j = i; (j > 0) && PrintsBefore(record, sorted[j - 1]); j--)
+	    sorted[j] = sorted[j - 1];		// there are only a few
+	sorted[j] = record;
+    }
+
+    printf("Synchronization profile (ticks), by total wait:\n");
+    printf("%-24s %4s %4s %9s %9s %10s %8s %9s %8s\n", "name", "kind",
+	"objs", "acquired", "contended", "total wait", "max wait",
+	"mean hold", "max hold");
+    for (i = 0; i < numRecords; i++) {
+	record = sorted[i];
+	printf("%-24.24s %4s %4d %9d %9d %10d %8d ", record->name,
+	    (record->kind == LockKind) ? "lock" : "sem", record->numObjects,
+	    record->acquisitions, record->contended, record->totalWait,
+	    record->maxWait);
+	if (record->releases > 0)
+	    printf("%9d %8d\n", record->totalHold / record->releases,
+		record->maxHold);
+	else
+	    printf("%9s %8s\n", "-", "-");
+    }
+    delete [] sorted;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::WriteJson
+// 	Write the records to "fp" as a "synch" member of a JSON object:
+//	an array with an object per record, in no particular order.
+//	Names are debug names, without quotes or backslashes, so they
+//	need no escaping.
+//----------------------------------------------------------------------
+
+void
+SynchProfiler::WriteJson(FILE *fp)
+{
+    SynchRecord *record;
+
+    fprintf(fp, "  \"synch\": [");
+    for (record = records; record != NULL; record = record->next)
+	fprintf(fp, "%s\n    {\"name\": \"%s\", \"kind\": \"%s\", "
+	    "\"objects\": %d, \"acquired\": %d, \"contended\": %d, "
+	    "\"totalWait\": %d, \"maxWait\": %d, \"releases\": %d, "
+	    "\"totalHold\": %d, \"maxHold\": %d}",
+	    (record == records) ? "" : ",", record->name,
+	    (record->kind == LockKind) ? "lock" : "sem", record->numObjects,
+	    record->acquisitions, record->contended, record->totalWait,
+	    record->maxWait, record->releases, record->totalHold,
+	    record->maxHold);
+    fprintf(fp, "\n  ]");
+}
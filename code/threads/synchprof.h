@@ -0,0 +1,67 @@
+// synchprof.h
+//	Data structures to profile contention for semaphores and locks.
+//
+//	With profiling on (nachos -sp), every semaphore and lock counts
+//	how often it was taken, how often the taker had to wait, and for
+//	how long, in simulated ticks; locks also time how long they are
+//	held.  Objects with the same debug name share one record, so
+//	that, say, the locks of all the open files add up together.
+//	The records are printed when Nachos halts, worst wait first.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHPROF_H
+#define SYNCHPROF_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The kinds of synchronization object that get profiled
+enum SynchKind { SemaphoreKind, LockKind };
+
+// The following class defines the profile of every synchronization
+// object of one kind with one name.
+
+class SynchRecord {
+  public:
+    SynchRecord(char *debugName, SynchKind whichKind);
+    ~SynchRecord();
+
+    void Acquired(bool waited, int ticks);	// Taken, after waiting
+					// "ticks" if "waited" is TRUE
+    void Released(int ticks);		// Lock released, after being held
+					// for "ticks"
+
+    char *name;				// debug name of the objects
+    SynchKind kind;			// ... and what they are
+    int numObjects;			// how many there were
+    int acquisitions;			// times P or Acquire returned
+    int contended;			// ... after having to wait
+    int totalWait, maxWait;		// ticks spent waiting
+    int releases;			// times a lock was released
+    int totalHold, maxHold;		// ticks locks were held
+
+    SynchRecord *next;			// next record in the profiler
+};
+
+// The following class defines the collection of all the records.
+
+class SynchProfiler {
+  public:
+    SynchProfiler();			// Start with no records
+    ~SynchProfiler();			// De-allocate the records
+
+    SynchRecord *Find(char *name, SynchKind kind);
+					// Return the record a new object
+					// should use, creating it if need be
+    void Print();			// Print the records, by total wait
+    void WriteJson(FILE *fp);		// Write them as a JSON member
+
+  private:
+    SynchRecord *records;		// every record so far
+    int numRecords;			// ... and how many there are
+};
+
+#endif // SYNCHPROF_H
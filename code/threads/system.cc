@@ -7,6 +7,9 @@
 
 #include "copyright.h"
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "blockcache.h"
+#endif
 
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
@@ -18,6 +21,10 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+Alarm *alarmClock;			// threads sleeping until a given time
+EventLog *eventLog;			// record/replay of external inputs
+SynchProfiler *synchProfiler;		// semaphore and lock contention
+Tracer *tracer;				// event tracing (-tr)
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -36,6 +43,9 @@ PostOffice *postOffice;
 #endif
 
 
+static char *statsFileName = NULL;	// where to write the statistics
+					// as JSON (-sj), if anywhere
+
 // External definition, to allow us to take a pointer to this function
 extern void Cleanup();
 
@@ -58,12 +68,27 @@ extern void Cleanup();
 //		whether it needs it or not.
 //----------------------------------------------------------------------
 static void
-TimerInterruptHandler(int dummy)
+TimerInterruptHandler(intptr_t dummy)
 {
     if (interrupt->getStatus() != IdleMode)
 	interrupt->YieldOnReturn();
 }
 
+//----------------------------------------------------------------------
+// AbortCleanup
+// 	Nachos is aborting.  Save what would otherwise be lost -- the
+//	end of the event log, and the trace buffer, which shows what led
+//	up to the abort -- without de-allocating anything.
+//----------------------------------------------------------------------
+static void
+AbortCleanup()
+{
+    if (eventLog != NULL)
+	eventLog->End();
+    if (tracer != NULL)
+	tracer->Save();
+}
+
 //----------------------------------------------------------------------
 // Initialize
 // 	Initialize Nachos global data structures.  Interpret command
@@ -79,17 +104,32 @@ Initialize(int argc, char **argv)
 {
     int argCount;
     char* debugArgs = "";
+    char *logSpec = "";			// LOG levels, by subsystem
     bool randomYield = FALSE;
+    char *eventLogName = NULL;		// record or replay inputs
+    bool replay = FALSE;
+    bool profileSynch = FALSE;		// profile semaphores and locks
+    bool strideScheduling = FALSE;	// share the CPU by tickets
+    char *traceName = NULL;		// trace events to this file
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    bool instrMix = FALSE;	// keep the instruction mix statistics
+    bool fuse = TRUE;		// run common instruction pairs in one step
+    bool translate = FALSE;	// run user code from translated blocks
+    char *checkpointName = NULL;	// save a checkpoint to this file
+    int checkpointTime = 0;	// ... at this time
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
 #endif
+#ifdef FILESYS
+    bool diskLatency = FALSE;	// time disk requests
+#endif
 #ifdef NETWORK
     double rely = 1;		// network reliability
     int netname = 0;		// UNIX socket name
+    LinkModel link;		// network bandwidth, delay and queue
 #endif
     
     for (argc--, argv++; argc > 0; argc -= argCount, argv += argCount) {
@@ -101,21 +141,60 @@ Initialize(int argc, char **argv)
 	    	debugArgs = *(argv + 1);
 	    	argCount = 2;
 	    }
+	} else if (!strcmp(*argv, "-lv")) {
+	    ASSERT(argc > 1);
+	    logSpec = *(argv + 1);
+	    argCount = 2;
 	} else if (!strcmp(*argv, "-rs")) {
 	    ASSERT(argc > 1);
 	    RandomInit(atoi(*(argv + 1)));	// initialize pseudo-random
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-rec") || !strcmp(*argv, "-rep")) {
+	    ASSERT(argc > 1);
+	    replay = !strcmp(*argv, "-rep");
+	    eventLogName = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-sp"))
+	    profileSynch = TRUE;
+	else if (!strcmp(*argv, "-pt"))
+	    reportThreadTimes = TRUE;
+	else if (!strcmp(*argv, "-ss"))
+	    strideScheduling = TRUE;
+	else if (!strcmp(*argv, "-tr")) {
+	    ASSERT(argc > 1);
+	    traceName = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-sj")) {
+	    ASSERT(argc > 1);
+	    statsFileName = *(argv + 1);
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-ms"))
+	    instrMix = TRUE;
+	else if (!strcmp(*argv, "-nf"))
+	    fuse = FALSE;
+	else if (!strcmp(*argv, "-j"))
+	    translate = TRUE;
+	else if (!strcmp(*argv, "-ck")) {
+	    ASSERT(argc > 2);
+	    checkpointTime = atoi(*(argv + 1));
+	    checkpointName = *(argv + 2);
+	    argCount = 3;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
 	    format = TRUE;
 #endif
+#ifdef FILESYS
+	if (!strcmp(*argv, "-dh"))
+	    diskLatency = TRUE;
+#endif
 #ifdef NETWORK
 	if (!strcmp(*argv, "-l")) {
 	    ASSERT(argc > 1);
@@ -125,14 +204,45 @@ Initialize(int argc, char **argv)
 	    ASSERT(argc > 1);
 	    netname = atoi(*(argv + 1));
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-nb")) {
+	    ASSERT(argc > 1);
+	    link.bandwidth = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-nd")) {
+	    ASSERT(argc > 1);
+	    link.latency = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-nj")) {
+	    ASSERT(argc > 1);
+	    link.jitter = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-nq")) {
+	    ASSERT(argc > 1);
+	    link.queueSize = atoi(*(argv + 1));
+	    argCount = 2;
 	}
 #endif
     }
 
     DebugInit(debugArgs);			// initialize DEBUG messages
+    LogInit(logSpec);				// ... and LOG messages
     stats = new Statistics();			// collect statistics
+    if (eventLogName != NULL)			// must precede the devices
+	eventLog = new EventLog(eventLogName, replay);
+    if (profileSynch)				// must precede any semaphore
+	synchProfiler = new SynchProfiler();	// or lock
+    if (traceName != NULL)			// must precede any thread
+	tracer = new Tracer(traceName);
+#ifdef USER_PROGRAM
+    stats->keepInstrMix = instrMix;
+#endif
+#ifdef FILESYS
+    stats->keepDiskLatency = diskLatency;
+#endif
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new Scheduler();		// initialize the ready queue
+    PreallocateStacks(NumPreallocatedStacks);	// for the first threads
+    alarmClock = new Alarm();			// for timed sleeps
     if (randomYield)				// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
@@ -143,12 +253,21 @@ Initialize(int argc, char **argv)
     // object to save its state. 
     currentThread = new Thread("main");		
     currentThread->setStatus(RUNNING);
+    if (strideScheduling)
+	scheduler->SetPolicy(StridePolicy);
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
+    CallOnAbort(AbortCleanup);			// if an ASSERT fails
+    CallOnBadAddress(StackOverflowHandler);	// if a stack overflows
     
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
+    machine->fuseInstructions = fuse;
+    if (translate)
+	machine->blockCache = new BlockCache(machine->mainMemory);
+    if (checkpointName != NULL)
+	machine->CheckpointAt(checkpointTime, checkpointName);
 #endif
 
 #ifdef FILESYS
@@ -160,8 +279,47 @@ Initialize(int argc, char **argv)
 #endif
 
 #ifdef NETWORK
-    postOffice = new PostOffice(netname, rely, 10);
+    postOffice = new PostOffice(netname, rely, 10, &link);
+#endif
+}
+
+//----------------------------------------------------------------------
+// ExportStats
+// 	Write every statistic we have to the file named with -sj, as one
+//	JSON object, for programs to read:
+//
+//	  "schema", "version" -- "nachos-stats" and 1; the version goes
+//		up whenever a member changes meaning or goes away
+//	  "ticks", "disk", "console", "paging", "network", "instructions"
+//		-- the counters in Statistics, always there
+//	  "diskLatency" -- disk request time histograms, with -dh
+//	  "opcodes" -- user instructions executed, by mnemonic, with -ms
+//	  "synch" -- semaphore and lock contention, with -sp
+//----------------------------------------------------------------------
+
+static void
+ExportStats(char *name)
+{
+    FILE *fp = fopen(name, "w");
+
+    if (fp == NULL) {
+	printf("Unable to write statistics to %s\n", name);
+	return;
+    }
+    fprintf(fp, "{\n  \"schema\": \"nachos-stats\",\n  \"version\": 1,\n");
+    stats->WriteJson(fp);
+#ifdef USER_PROGRAM
+    if (stats->keepInstrMix) {
+	fprintf(fp, ",\n");
+	machine->WriteInstrMix(fp);
+    }
 #endif
+    if (synchProfiler != NULL) {
+	fprintf(fp, ",\n");
+	synchProfiler->WriteJson(fp);
+    }
+    fprintf(fp, "\n}\n");
+    fclose(fp);
 }
 
 //----------------------------------------------------------------------
@@ -171,6 +329,12 @@ Initialize(int argc, char **argv)
 void
 Cleanup()
 {
+    if (statsFileName != NULL)
+	ExportStats(statsFileName);
+    if (tracer != NULL)
+	tracer->Save();
+    if (synchProfiler != NULL)
+	synchProfiler->Print();
     printf("\nCleaning up...\n");
 #ifdef NETWORK
     delete postOffice;
@@ -189,8 +353,12 @@ Cleanup()
 #endif
     
     delete timer;
+    delete alarmClock;
     delete scheduler;
     delete interrupt;
+    delete eventLog;
+    delete synchProfiler;
+    delete tracer;
     
     Exit(0);
 }
@@ -15,6 +15,10 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "eventlog.h"
+#include "synchprof.h"
+#include "trace.h"
+#include "alarm.h"
 
 // Fix bzero(), bcopy().
 #define	bzero(a, b)		memset(a, 0, b)
@@ -32,6 +36,12 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern Alarm *alarmClock;			// threads sleeping until a
+						// given time
+extern EventLog *eventLog;			// inputs being recorded or
+						// replayed, NULL if neither
+extern SynchProfiler *synchProfiler;		// semaphore and lock contention,
+						// NULL unless profiling
 
 #ifdef USER_PROGRAM
 #include "machine.h"
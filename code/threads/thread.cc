@@ -24,6 +24,88 @@
 					// execution stack, for detecting 
 					// stack overflows
 
+#ifdef HOST_SNAKE			// Stacks grow upward on the Snakes
+#define Fencepost(stack)	(*(unsigned int *) &(stack)[StackSize - 1])
+#else
+#define Fencepost(stack)	(*(unsigned int *) (stack))
+#endif
+
+// The pool of free stacks (see NewStack and FreeStack), last in, first
+// out.  Every stack in it carries its fencepost, so that we notice if
+// anything writes past the end of a stack after its thread is gone.
+
+static int *stackPool[StackPoolSize];
+static int numPooledStacks = 0;
+
+bool reportThreadTimes = FALSE;		// see Thread::PrintTimes
+
+//----------------------------------------------------------------------
+// AllocStack
+// 	Get a new, fence-posted, execution stack from the host.
+//----------------------------------------------------------------------
+
+static int *
+AllocStack()
+{
+    int *stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+
+    Fencepost(stack) = STACK_FENCEPOST;
+    return stack;
+}
+
+//----------------------------------------------------------------------
+// NewStack
+// 	Return a fence-posted execution stack for a new thread: the
+//	most recently freed one if there is any, a new one from the host
+//	otherwise.
+//
+//	Like the rest of the thread system, this runs with no interrupt
+//	in between, so the pool needs no lock.
+//----------------------------------------------------------------------
+
+static int *
+NewStack()
+{
+    int *stack;
+
+    if (numPooledStacks == 0)
+	return AllocStack();
+    stack = stackPool[--numPooledStacks];
+    ASSERT(Fencepost(stack) == STACK_FENCEPOST);
+    return stack;
+}
+
+//----------------------------------------------------------------------
+// FreeStack
+// 	Put the stack of a finished thread back in the pool, or give it
+//	back to the host if the pool is full.  Check its fencepost on
+//	the way: the thread may have overflowed it since it last ran.
+//----------------------------------------------------------------------
+
+static void
+FreeStack(int *stack)
+{
+    ASSERT(Fencepost(stack) == STACK_FENCEPOST);
+    if (numPooledStacks == StackPoolSize)
+	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+    else
+	stackPool[numPooledStacks++] = stack;
+}
+
+//----------------------------------------------------------------------
+// PreallocateStacks
+// 	Put "howMany" new stacks in the pool, so that the first threads
+//	to be forked don't have to wait for the host.
+//----------------------------------------------------------------------
+
+void
+PreallocateStacks(int howMany)
+{
+    ASSERT(numPooledStacks + howMany <= StackPoolSize);
+    while (howMany-- > 0)
+	stackPool[numPooledStacks++] = AllocStack();
+}
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -37,9 +119,16 @@ Thread::Thread(char* threadName)
     currentDirectorySector = -1;  // Non initialisé
 
     name = threadName;
+    traceId = (tracer != NULL) ? tracer->NewThread(threadName) : 0;
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
+    ResetTimes();
+    basePriority = priority = 0;
+    setTickets(DefaultTickets);
+    pass = cpuAtDispatch = 0;
+    waitingFor = NULL;
+    locksHeld = NULL;
 #ifdef USER_PROGRAM
     space = NULL;
 #endif
@@ -64,7 +153,7 @@ Thread::~Thread()
 
     ASSERT(this != currentThread);
     if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+	FreeStack(stack);
 }
 
 //----------------------------------------------------------------------
@@ -88,10 +177,10 @@ Thread::~Thread()
 //----------------------------------------------------------------------
 
 void 
-Thread::Fork(VoidFunctionPtr func, int arg)
+Thread::Fork(VoidFunctionPtr func, intptr_t arg)
 {
-    DEBUG('t', "Forking thread \"%s\" with func = 0x%x, arg = %d\n",
-	  name, (int) func, arg);
+    DEBUG('t', "Forking thread \"%s\" with func = %p, arg = %ld\n",
+	  name, func, (long) arg);
      // IFT320: Hériter du répertoire courant du parent
     if (currentThread != NULL) {
         this->currentDirectorySector = currentThread->currentDirectorySector;
@@ -111,6 +200,13 @@ Thread::Fork(VoidFunctionPtr func, int arg)
 //	that has been allocated for it.  If we had a smarter compiler,
 //	we wouldn't need to worry about this, but we don't.
 //
+//	Every stack has an inaccessible guard page beyond each end, so
+//	an overflow normally stops Nachos at the instruction that
+//	caused it (see StackOverflowHandler); the fencepost only catches
+//	the rare frame big enough to jump clear over the guard page.
+//	Scheduler::Run used to check it on every context switch; now the
+//	stack pool checks it when a thread finishes.
+//
 // 	NOTE: Nachos will not catch all stack overflow conditions.
 //	In other words, your program may still crash because of an overflow.
 //
@@ -124,11 +220,45 @@ void
 Thread::CheckOverflow()
 {
     if (stack != NULL)
-#ifdef HOST_SNAKE			// Stacks grow upward on the Snakes
-	ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
-#else
-	ASSERT((unsigned int) *stack == STACK_FENCEPOST);
-#endif
+	ASSERT(Fencepost(stack) == STACK_FENCEPOST);
+}
+
+//----------------------------------------------------------------------
+// Thread::IsStackGuard
+// 	Return TRUE if "addr" is in one of the guard pages just off the
+//	ends of this thread's stack.
+//----------------------------------------------------------------------
+
+bool
+Thread::IsStackGuard(char *addr)
+{
+    return (stack != NULL) && 
+	InBoundedArrayGuard((char *) stack, StackSize * sizeof(int), addr);
+}
+
+//----------------------------------------------------------------------
+// StackOverflowHandler
+// 	Called when Nachos references an address it may not (on a
+//	SIGSEGV), with that address.  If it is in a guard page of the
+//	running thread's stack, that thread has overflowed its stack:
+//	say so, rather than just dying of a segmentation fault.
+//
+//	We are running on the signal stack, not the thread's, so there
+//	is room to call printf.  There is no way to continue.
+//----------------------------------------------------------------------
+
+void
+StackOverflowHandler(char *addr)
+{
+    if ((currentThread != NULL) && currentThread->IsStackGuard(addr))
+	printf("Stack overflow in thread \"%s\": reference to %p, beyond "
+	    "its %d-byte stack\n", currentThread->getName(), addr,
+	    (int) (StackSize * sizeof(int)));
+    else
+	printf("Reference to bad address %p, in thread \"%s\"\n", addr,
+	    (currentThread != NULL) ? currentThread->getName() : "none");
+    fflush(stdout);
+    Abort();
 }
 
 //----------------------------------------------------------------------
@@ -155,6 +285,8 @@ Thread::Finish ()
     
     DEBUG('t', "Finishing thread \"%s\"\n", getName());
     
+    if (reportThreadTimes)
+	PrintTimes();
     threadToBeDestroyed = currentThread;
     Sleep();					// invokes SWITCH
     // not reached
@@ -162,11 +294,12 @@ Thread::Finish ()
 
 //----------------------------------------------------------------------
 // Thread::Yield
-// 	Relinquish the CPU if any other thread is ready to run.
-//	If so, put the thread on the end of the ready list, so that
+// 	Relinquish the CPU if any other thread of the same or higher
+//	priority is ready to run.  If so, put the thread behind the
+//	other threads of its priority on the ready list, so that
 //	it will eventually be re-scheduled.
 //
-//	NOTE: returns immediately if no other thread on the ready queue.
+//	NOTE: returns immediately if no such thread on the ready queue.
 //	Otherwise returns when the thread eventually works its way
 //	to the front of the ready list and gets re-scheduled.
 //
@@ -188,11 +321,12 @@ Thread::Yield ()
     
     DEBUG('t', "Yielding thread \"%s\"\n", getName());
     
+    scheduler->ReadyToRun(this);
     nextThread = scheduler->FindNextToRun();
-    if (nextThread != NULL) {
-	scheduler->ReadyToRun(this);
+    if (nextThread != this)
 	scheduler->Run(nextThread);
-    }
+    else
+	setStatus(RUNNING);		// no one else to run, keep going
     (void) interrupt->SetLevel(oldLevel);
 }
 
@@ -225,13 +359,194 @@ Thread::Sleep ()
     
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
-    status = BLOCKED;
+    setStatus(BLOCKED);
+    scheduler->Blocked(this);
     while ((nextThread = scheduler->FindNextToRun()) == NULL)
 	interrupt->Idle();	// no one to run, wait for an interrupt
         
     scheduler->Run(nextThread); // returns when we've been signalled
 }
 
+//----------------------------------------------------------------------
+// Thread::setStatus
+// 	Change the state of the thread, first charging it for the time
+//	spent in the old state.  Called by the scheduler as the thread
+//	is made ready, and switched to; by Sleep as it blocks.
+//----------------------------------------------------------------------
+
+void
+Thread::setStatus(ThreadStatus st)
+{
+    ChargeTime();
+    status = st;
+}
+
+//----------------------------------------------------------------------
+// Thread::ChargeTime
+// 	Add the time spent in the current state, since it was entered or
+//	last charged, to the thread's total for that state.
+//
+//	While the thread runs, the machine-wide user and system tick
+//	counts only advance on its behalf, so its share is what they
+//	advanced by.  That way, ticks charged by Interrupt::QuietTick,
+//	for user code run back to back, are counted as well.
+//----------------------------------------------------------------------
+
+void
+Thread::ChargeTime()
+{
+    switch (status) {
+      case RUNNING:
+	userTicks += stats->userTicks - userSince;
+	systemTicks += stats->systemTicks - systemSince;
+	break;
+      case READY:
+	readyTicks += stats->totalTicks - statusSince;
+	break;
+      case BLOCKED:
+	blockedTicks += stats->totalTicks - statusSince;
+	break;
+      default:
+	break;
+    }
+    statusSince = stats->totalTicks;
+    userSince = stats->userTicks;
+    systemSince = stats->systemTicks;
+}
+
+//----------------------------------------------------------------------
+// Thread::ResetTimes
+// 	Start counting the thread's time from scratch -- when it is
+//	created, or when a checkpoint has put the clock back.
+//----------------------------------------------------------------------
+
+void
+Thread::ResetTimes()
+{
+    userTicks = systemTicks = readyTicks = blockedTicks = 0;
+    statusSince = stats->totalTicks;
+    userSince = stats->userTicks;
+    systemSince = stats->systemTicks;
+}
+
+//----------------------------------------------------------------------
+// Thread::CpuTicks
+// 	Return the time the thread has spent running, user code and
+//	kernel, up to now.
+//----------------------------------------------------------------------
+
+int
+Thread::CpuTicks()
+{
+    ChargeTime();
+    return userTicks + systemTicks;
+}
+
+//----------------------------------------------------------------------
+// Thread::PrintTimes
+// 	Print how much time the thread spent running user code, running
+//	the kernel, waiting on the ready list, and blocked.
+//----------------------------------------------------------------------
+
+void
+Thread::PrintTimes()
+{
+    ChargeTime();
+    printf("Thread \"%s\": user %d, system %d, ready %d, blocked %d ticks\n",
+	name, userTicks, systemTicks, readyTicks, blockedTicks);
+}
+
+//----------------------------------------------------------------------
+// Thread::setPriority
+// 	Change the priority of the thread.  The scheduler runs the ready
+//	thread with the highest priority first (see Scheduler::ReadyToRun).
+//
+//	While the thread holds a lock that a higher priority thread is
+//	waiting for, it keeps running at that higher priority (see
+//	Lock::Acquire), whatever its own.
+//
+//	"newPriority" -- the thread's own priority; the default is 0
+//----------------------------------------------------------------------
+
+void
+Thread::setPriority(int newPriority)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    basePriority = newPriority;
+    RecomputePriority();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Thread::setTickets
+// 	Change the number of tickets the thread holds.  Under stride
+//	scheduling, ready threads share the CPU in proportion to their
+//	tickets; the thread's stride, how far its pass advances per
+//	tick it runs, is inversely proportional to them.
+//
+//	"howMany" -- from 1 to StrideOne; the default is DefaultTickets
+//----------------------------------------------------------------------
+
+void
+Thread::setTickets(int howMany)
+{
+    ASSERT((howMany > 0) && (howMany <= StrideOne));
+    tickets = howMany;
+    stride = StrideOne / howMany;
+}
+
+//----------------------------------------------------------------------
+// Thread::RecomputePriority
+// 	Work out the priority the thread should run at: its own, or that
+//	of the highest priority thread waiting for one of its locks,
+//	whichever is higher.
+//
+//	NOTE: we assume interrupts are already disabled.
+//----------------------------------------------------------------------
+
+void
+Thread::RecomputePriority()
+{
+    int newPriority = basePriority;
+    int waiterPriority;
+    Lock *lock;
+
+    if (priorityInheritance)
+	for (lock = locksHeld; lock != NULL; lock = lock->nextHeld)
+	    if (lock->HighestWaiter(&waiterPriority) &&
+					(waiterPriority > newPriority))
+		newPriority = waiterPriority;
+    ChangePriority(newPriority);
+}
+
+//----------------------------------------------------------------------
+// Thread::ChangePriority
+// 	Set the priority the thread runs at, and move it to its new place
+//	among the threads that are ready, or that wait for the same lock.
+//
+//	In the latter case, the holder of that lock may have to change
+//	priority in turn, and so on down the chain of waiting threads.
+//	The chain stops at the first thread whose priority stays the same.
+//
+//	NOTE: we assume interrupts are already disabled.
+//----------------------------------------------------------------------
+
+void
+Thread::ChangePriority(int newPriority)
+{
+    if (newPriority == priority)
+	return;
+
+    DEBUG('t', "Thread \"%s\" goes from priority %d to %d\n", getName(),
+							priority, newPriority);
+    priority = newPriority;
+    if (status == READY)
+	scheduler->Reprioritize(this);
+    else if (waitingFor != NULL)
+	waitingFor->Requeue(this);	// passes it on to the lock holder
+}
+
 //----------------------------------------------------------------------
 // ThreadFinish, InterruptEnable, ThreadPrint
 //	Dummy functions because C++ does not allow a pointer to a member
@@ -242,7 +557,7 @@ Thread::Sleep ()
 
 static void ThreadFinish()    { currentThread->Finish(); }
 static void InterruptEnable() { interrupt->Enable(); }
-void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
+void ThreadPrint(intptr_t arg){ Thread *t = (Thread *)arg; t->Print(); }
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
@@ -257,20 +572,19 @@ void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 //----------------------------------------------------------------------
 
 void
-Thread::StackAllocate (VoidFunctionPtr func, int arg)
+Thread::StackAllocate (VoidFunctionPtr func, intptr_t arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = NewStack();			// fence-posted already
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
     stackTop = stack + 16;	// HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
 #else
     // i386 & MIPS & SPARC stack works from high addresses to low addresses
 #ifdef HOST_SPARC
     // SPARC stack must contains at least 1 activation record to start with.
     stackTop = stack + StackSize - 96;
-#else  // HOST_MIPS  || HOST_i386
+#else  // HOST_MIPS  || HOST_i386 || HOST_x86_64
     stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
 #ifdef HOST_i386
     // the 80386 passes the return address on the stack.  In order for
@@ -279,15 +593,22 @@ Thread::StackAllocate (VoidFunctionPtr func, int arg)
     // ThreadRoot.
     *(--stackTop) = (int)ThreadRoot;
 #endif
+#ifdef HOST_x86_64
+    // Same trick as the 80386, but the return address is 8 bytes wide,
+    // and the x86-64 ABI wants %rsp 16-byte aligned at every call.
+    // ThreadRoot pushes %rbp once before calling out, so the slot
+    // holding its address must itself sit on a 16-byte boundary.
+    stackTop -= 4;
+    *(VoidNoArgFunctionPtr *) stackTop = ThreadRoot;
+#endif
 #endif  // HOST_SPARC
-    *stack = STACK_FENCEPOST;
 #endif  // HOST_SNAKE
     
-    machineState[PCState] = (int) ThreadRoot;
-    machineState[StartupPCState] = (int) InterruptEnable;
-    machineState[InitialPCState] = (int) func;
+    machineState[PCState] = (intptr_t) ThreadRoot;
+    machineState[StartupPCState] = (intptr_t) InterruptEnable;
+    machineState[InitialPCState] = (intptr_t) func;
     machineState[InitialArgState] = arg;
-    machineState[WhenDonePCState] = (int) ThreadFinish;
+    machineState[WhenDonePCState] = (intptr_t) ThreadFinish;
 }
 
 #ifdef USER_PROGRAM
@@ -60,14 +60,34 @@
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 #define StackSize	(4 * 1024)	// in words
 
+// Under stride scheduling (see Scheduler::SetPolicy), threads get CPU
+// time in proportion to their tickets.
+#define DefaultTickets	100		// a thread's tickets to start with
+#define StrideOne	(1 << 20)	// stride of a thread with one ticket
 
+// The stacks of finished threads are kept in a pool, for new threads
+// to reuse, rather than being handed back to the host.
+#define StackPoolSize		16	// at most this many are kept
+#define NumPreallocatedStacks	4	// the pool starts with this many
 
+extern void PreallocateStacks(int howMany);	// Fill the pool ahead of time
+
+extern bool reportThreadTimes;		// Threads print where their time
+					// went as they finish (-pt)
+
+extern void StackOverflowHandler(char *addr);	// Called on references to
+						// bad addresses, such as
+						// a stack's guard page
+
+
+
+class Lock;
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
 
 // external function, dummy routine whose sole job is to call Thread::Print
-extern void ThreadPrint(int arg);	 
+extern void ThreadPrint(intptr_t arg);	 
 
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
@@ -85,7 +105,8 @@ class Thread {
     // NOTE: DO NOT CHANGE the order of these first two members.
     // THEY MUST be in this position for SWITCH to work.
     int* stackTop;			 // the current stack pointer
-    int machineState[MachineStateSize];  // all registers except for stackTop
+    intptr_t machineState[MachineStateSize];  // all registers except for
+					      // stackTop
 
   public:
     Thread(char* debugName);		// initialize a Thread 
@@ -96,7 +117,8 @@ class Thread {
 
     // basic thread operations
 
-    void Fork(VoidFunctionPtr func, int arg); 	// Make thread run (*func)(arg)
+    void Fork(VoidFunctionPtr func, intptr_t arg);	// Make thread run
+						// (*func)(arg)
     void Yield();  				// Relinquish the CPU if any 
 						// other thread is runnable
     void Sleep();  				// Put the thread to sleep and 
@@ -105,9 +127,25 @@ class Thread {
     
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
-    void setStatus(ThreadStatus st) { status = st; }
+    bool IsStackGuard(char *addr);		// Is "addr" just off the
+						// ends of its stack?
+    void setStatus(ThreadStatus st);	// Change state, and charge the
+					// time spent in the old one
+    ThreadStatus getStatus() { return status; }
+    void setPriority(int newPriority);	// Higher priority threads run
+					// first (the default is 0)
+    int getPriority() { return priority; }	// ... as raised, if need
+					// be, by priority inheritance
+    void setTickets(int howMany);	// Share of the CPU to get under
+					// stride scheduling, relative to
+					// other threads' tickets
+    int getTickets() { return tickets; }
     char* getName() { return (name); }
+    int getTraceId() { return traceId; }	// number in the trace (-tr)
     void Print() { printf("%s, ", name); }
+    int CpuTicks();			// Time spent running so far
+    void PrintTimes();			// Print where the thread's time went
+    void ResetTimes();			// Start counting its time afresh
 	  void SetCurrentDirectory(int sector) { currentDirectorySector = sector; }
     int GetCurrentDirectory() { return currentDirectorySector; }
 	#ifdef FILESYSzz
@@ -124,11 +162,42 @@ class Thread {
 					// (If NULL, don't deallocate stack)
     ThreadStatus status;		// ready, running or blocked
     char* name;
+    int traceId;			// our number in the trace, or 0
+    int basePriority;			// priority given by setPriority
+    int priority;			// ... or higher, while we hold a lock
+					// a higher priority thread waits for
+    Lock *waitingFor;			// lock we wait for in Acquire, if any
+    Lock *locksHeld;			// locks we hold, chained through
+					// Lock::nextHeld
+
+    int userTicks, systemTicks;		// time spent running user code or
+					// the kernel, interrupts included
+    int readyTicks, blockedTicks;	// time spent on the ready list, or
+					// asleep
+    int statusSince;			// when "status" last changed
+    int userSince, systemSince;		// stats->userTicks and systemTicks
+					// at that time
+
+    int tickets;			// for stride scheduling, and the
+    int stride;				// ... resulting StrideOne / tickets
+    int pass;				// virtual time we have run to, or,
+					// while BLOCKED, how far ahead of
+					// the scheduler's we were
+    int cpuAtDispatch;			// CpuTicks() when last dispatched
     int currentDirectorySector;
 
-    void StackAllocate(VoidFunctionPtr func, int arg);
+    void StackAllocate(VoidFunctionPtr func, intptr_t arg);
     					// Allocate a stack for thread.
 					// Used internally by Fork()
+    void ChargeTime();			// Account for the time spent in
+					// the current state until now
+    void RecomputePriority();		// Set priority from basePriority
+					// and the waiters for our locks
+    void ChangePriority(int newPriority);
+					// Set priority, passing it on to
+					// whoever it has to
+    friend class Lock;
+    friend class Scheduler;
 
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
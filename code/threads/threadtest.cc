@@ -5,12 +5,19 @@
 //	back and forth between themselves by calling Thread::Yield, 
 //	to illustratethe inner workings of the thread system.
 //
+//	Also, a test of priority inheritance on locks (PriorityTest),
+//	of stride scheduling (StrideTest), of bounded synchronized
+//	lists (SynchListTest), and of work queues (WorkQueueTest).
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
 #include "system.h"
+#include "synch.h"
+#include "synchlist.h"
+#include "workqueue.h"
 
 //----------------------------------------------------------------------
 // SimpleThread
@@ -22,12 +29,12 @@
 //----------------------------------------------------------------------
 
 void
-SimpleThread(int which)
+SimpleThread(intptr_t which)
 {
     int num;
     
     for (num = 0; num < 5; num++) {
-	printf("*** thread %d looped %d times\n", which, num);
+	printf("*** thread %d looped %d times\n", (int) which, num);
         currentThread->Yield();
     }
 }
@@ -49,3 +56,361 @@ ThreadTest()
     SimpleThread(0);
 }
 
+
+// Threads for the priority inversion test: "low" holds a lock that
+// "high" wants, while two "medium" threads keep the CPU busy.
+
+static Lock *inversionLock;
+static Semaphore *lowHasLock;		// "low" has taken the lock
+static Semaphore *inversionDone;	// one more thread is done
+static char *finishOrder[4];		// the threads, as they finish
+static int numFinished;
+static int highWaited;			// ticks "high" waited for the lock
+
+static void
+Finished(char *who)
+{
+    finishOrder[numFinished++] = who;
+    inversionDone->V();
+}
+
+static void
+LowThread(intptr_t arg)
+{
+    int i;
+
+    inversionLock->Acquire();
+    lowHasLock->V();
+    for (i = 0; i < 3; i++)		// some work, with the lock
+        currentThread->Yield();
+    inversionLock->Release();
+    Finished("low");
+}
+
+static void
+MediumThread(intptr_t arg)
+{
+    int i;
+
+    for (i = 0; i < 5; i++)		// some work, no lock needed
+        currentThread->Yield();
+    Finished("medium");
+}
+
+static void
+HighThread(intptr_t arg)
+{
+    int start = stats->totalTicks;
+
+    inversionLock->Acquire();
+    highWaited = stats->totalTicks - start;
+    inversionLock->Release();
+    Finished("high");
+}
+
+//----------------------------------------------------------------------
+// RunInversion
+// 	Let "low" (priority 1) take the lock, then start two "medium"
+//	threads (priority 2) and "high" (priority 3), and print how long
+//	"high" waited for the lock, and in which order the threads
+//	finished.
+//
+//	We run at a higher priority than any of them while we set things
+//	up, so they can't start before we are done.
+//----------------------------------------------------------------------
+
+static void
+RunInversion(bool inherit)
+{
+    Thread *t;
+    int i;
+
+    priorityInheritance = inherit;
+    numFinished = 0;
+    currentThread->setPriority(10);
+
+    t = new Thread("low");
+    t->setPriority(1);
+    t->Fork(LowThread, 0);
+    lowHasLock->P();
+
+    for (i = 0; i < 2; i++) {
+	t = new Thread("medium");
+	t->setPriority(2);
+	t->Fork(MediumThread, 0);
+    }
+    t = new Thread("high");
+    t->setPriority(3);
+    t->Fork(HighThread, 0);
+
+    for (i = 0; i < 4; i++)
+	inversionDone->P();
+    printf("Priority inheritance %s: high waited %d ticks for the lock\n",
+	inherit ? "on" : "off", highWaited);
+    printf("    finished: %s %s %s %s\n", finishOrder[0], finishOrder[1],
+	finishOrder[2], finishOrder[3]);
+    currentThread->setPriority(0);
+}
+
+//----------------------------------------------------------------------
+// PriorityTest
+// 	Show priority inversion, and priority inheritance putting an end
+//	to it: without inheritance, "high" waits for both "medium"
+//	threads to finish; with it, "high" is done before they are.
+//----------------------------------------------------------------------
+
+void
+PriorityTest()
+{
+    bool savedInheritance = priorityInheritance;
+
+    inversionLock = new Lock("inversion lock");
+    lowHasLock = new Semaphore("low has lock", 0);
+    inversionDone = new Semaphore("inversion done", 0);
+
+    RunInversion(FALSE);
+    RunInversion(TRUE);
+
+    priorityInheritance = savedInheritance;
+    delete inversionLock;
+    delete lowHasLock;
+    delete inversionDone;
+}
+
+// Threads for the stride scheduling test: each keeps the CPU busy,
+// yielding it after every bit of work, until told to stop.
+
+#define NumBusyThreads	3
+
+static int busyTickets[NumBusyThreads] = { 300, 200, 100 };
+static Thread *busyThreads[NumBusyThreads];
+static bool busyStop;			// time for the threads to stop
+static Semaphore *busyDone;		// one more thread has stopped
+
+static void
+BusyThread(intptr_t arg)
+{
+    while (!busyStop)
+        currentThread->Yield();
+    busyDone->V();
+}
+
+//----------------------------------------------------------------------
+// StrideTest
+// 	Show stride scheduling sharing the CPU in proportion to tickets:
+//	start three busy threads holding 300, 200 and 100 tickets, and
+//	print the share of the CPU each has had after a while, and after
+//	longer.  The shares should converge to one half, one third and
+//	one sixth.
+//
+//	We use the alarm clock to look at the shares, so we don't use
+//	the CPU ourselves in the meantime.
+//----------------------------------------------------------------------
+
+void
+StrideTest()
+{
+    static int checkpoints[] = { 1000, 10000, 100000 };
+    int cpu[NumBusyThreads];
+    int start, total, totalTickets = 0;
+    int i, j;
+    Thread *t;
+
+    scheduler->SetPolicy(StridePolicy);
+    busyStop = FALSE;
+    busyDone = new Semaphore("busy done", 0);
+    for (i = 0; i < NumBusyThreads; i++) {
+	t = new Thread("busy");
+	t->setTickets(busyTickets[i]);
+	t->Fork(BusyThread, i);
+	busyThreads[i] = t;
+	totalTickets += busyTickets[i];
+    }
+
+    start = stats->totalTicks;
+    for (j = 0; j < (int) (sizeof(checkpoints) / sizeof(int)); j++) {
+	alarmClock->WaitUntil(start + checkpoints[j]);
+	total = 0;
+	for (i = 0; i < NumBusyThreads; i++) {
+	    cpu[i] = busyThreads[i]->CpuTicks();
+	    total += cpu[i];
+	}
+	printf("After %6d ticks, CPU share (tickets share):", checkpoints[j]);
+	for (i = 0; i < NumBusyThreads; i++)
+	    printf(" %5.1f%% (%4.1f%%)", 100.0 * cpu[i] / total,
+		100.0 * busyTickets[i] / totalTickets);
+	printf("\n");
+    }
+
+    busyStop = TRUE;
+    for (i = 0; i < NumBusyThreads; i++)
+	busyDone->P();
+    delete busyDone;
+    scheduler->SetPolicy(PriorityPolicy);
+}
+
+// Threads for the synchronized list test: a producer appends numbered
+// items to a bounded list, a batch at a time, while we take them off
+// in batches.
+
+#define ListCapacity	4		// items the list can hold
+#define NumListItems	20		// items the producer appends
+#define ProducerBatch	6		// ... this many at a time
+
+static SynchList *boundedList;
+static bool producerDone;		// all the items are on the list
+static Semaphore *producerFinished;
+
+static void
+ProducerThread(intptr_t arg)
+{
+    void *batch[ProducerBatch];
+    int next = 0, i;
+
+    while (next < NumListItems) {
+	for (i = 0; (i < ProducerBatch) && (next < NumListItems); i++)
+	    batch[i] = (void *) (intptr_t) next++;
+	boundedList->AppendMany(batch, i);
+    }
+    producerDone = TRUE;
+    producerFinished->V();
+}
+
+//----------------------------------------------------------------------
+// SynchListTest
+// 	Show a bounded SynchList holding back its producer, and batches
+//	of items going through it with AppendMany and RemoveUpTo.
+//
+//	The producer runs first, and must block with the list full,
+//	partway through its first batch.  Then we take off whatever is
+//	there each time, and print how many items each batch held; they
+//	must come off in the order they went on.
+//----------------------------------------------------------------------
+
+void
+SynchListTest()
+{
+    void *batch[NumListItems];
+    int sizes[NumListItems];
+    int received = 0, numBatches = 0, i;
+    bool inOrder = TRUE, blocked;
+    Thread *t;
+
+    boundedList = new SynchList(ListCapacity);
+    producerFinished = new Semaphore("producer finished", 0);
+    producerDone = FALSE;
+    t = new Thread("producer");
+    t->Fork(ProducerThread, 0);
+    currentThread->Yield();		// the producer fills up the list
+    blocked = !producerDone;
+
+    while (received < NumListItems) {
+	sizes[numBatches] = boundedList->RemoveUpTo(batch, NumListItems);
+	for (i = 0; i < sizes[numBatches]; i++)
+	    if ((intptr_t) batch[i] != received + i)
+		inOrder = FALSE;
+	received += sizes[numBatches++];
+    }
+    producerFinished->P();
+
+    printf("SynchList test: producer %s with the list full, first "
+	"batch %d of %d items\n", blocked ? "blocked" : "did not block",
+	sizes[0], ListCapacity);
+    printf("SynchList test: %d items %s, in %d batches:", received,
+	inOrder ? "in order" : "OUT OF ORDER", numBatches);
+    for (i = 0; i < numBatches; i++)
+	printf(" %d", sizes[i]);
+    printf("\n");
+    delete boundedList;
+    delete producerFinished;
+}
+
+// Work for the work queue test: each piece notes that it ran, and
+// gives up the CPU partway through, so that the workers can interleave.
+
+#define NumUrgentItems		2	// work for the urgent queue
+#define NumBackgroundItems	4	// ... and for the background queue
+#define NumFlushedItems		6	// background work nobody waits for
+#define MaxWorkOrder	(NumUrgentItems + NumBackgroundItems)
+
+static char *workOrder[MaxWorkOrder];	// names of the work done, in order
+static int numWorkDone;
+
+static void
+NoteWork(intptr_t name)
+{
+    if (numWorkDone < MaxWorkOrder)
+	workOrder[numWorkDone] = (char *) name;
+    numWorkDone++;
+    currentThread->Yield();
+}
+
+//----------------------------------------------------------------------
+// WorkQueueTest
+// 	Show work queued at two priorities: an urgent queue with one
+//	worker at priority 3, and a background queue with two workers at
+//	priority 1.  We queue work on both, background work first, and
+//	wait for each piece on a semaphore of its own; the urgent work
+//	must all be done before any of the background work.
+//
+//	Then we queue more background work without semaphores and Flush
+//	the queue, which must not return before that work is done.  At
+//	last we delete both queues, which must stop all their workers,
+//	leaving nobody but us to run.
+//----------------------------------------------------------------------
+
+void
+WorkQueueTest()
+{
+    static char *urgentNames[NumUrgentItems] = { "U0", "U1" };
+    static char *backgroundNames[NumBackgroundItems] =
+					{ "B0", "B1", "B2", "B3" };
+    Semaphore *urgentDone[NumUrgentItems];
+    Semaphore *backgroundDone[NumBackgroundItems];
+    WorkQueue *urgent, *background;
+    bool urgentFirst = TRUE, flushed;
+    int i;
+
+    numWorkDone = 0;
+    currentThread->setPriority(10);	// queue it all before it starts
+    urgent = new WorkQueue("urgent", 1, 3);
+    background = new WorkQueue("background", 2, 1);
+    for (i = 0; i < NumBackgroundItems; i++) {
+	backgroundDone[i] = new Semaphore(backgroundNames[i], 0);
+	background->Queue(NoteWork, (intptr_t) backgroundNames[i],
+							backgroundDone[i]);
+    }
+    for (i = 0; i < NumUrgentItems; i++) {
+	urgentDone[i] = new Semaphore(urgentNames[i], 0);
+	urgent->Queue(NoteWork, (intptr_t) urgentNames[i], urgentDone[i]);
+    }
+    currentThread->setPriority(0);
+
+    for (i = 0; i < NumBackgroundItems; i++)
+	backgroundDone[i]->P();
+    for (i = 0; i < NumUrgentItems; i++)
+	urgentDone[i]->P();
+    printf("Work queue test: work done in the order");
+    for (i = 0; i < numWorkDone; i++) {
+	printf(" %s", workOrder[i]);
+	if ((i < NumUrgentItems) && (workOrder[i][0] != 'U'))
+	    urgentFirst = FALSE;
+    }
+    printf(", urgent work %s\n", urgentFirst ? "first" : "NOT FIRST");
+
+    for (i = 0; i < NumFlushedItems; i++)
+	background->Queue(NoteWork, (intptr_t) "flushed");
+    background->Flush();
+    flushed = (numWorkDone == MaxWorkOrder + NumFlushedItems);
+
+    delete urgent;
+    delete background;
+    printf("Work queue test: flush %s, workers %s\n",
+	flushed ? "waited for all the work" : "RETURNED EARLY",
+	scheduler->IsEmpty() ? "stopped" : "STILL RUNNING");
+
+    for (i = 0; i < NumBackgroundItems; i++)
+	delete backgroundDone[i];
+    for (i = 0; i < NumUrgentItems; i++)
+	delete urgentDone[i];
+}
@@ -0,0 +1,270 @@
+// trace.cc
+//	Routines to trace kernel and machine events into a ring buffer,
+//	and to convert the resulting trace file for a trace viewer.
+//
+//	The trace file holds TraceMagic, the number of threads and of
+//	records, then each thread's name (its length, then the
+//	characters), then the records, oldest first.  The records are
+//	written as they are kept in memory, so a trace is only read back
+//	on the kind of host that wrote it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "system.h"
+
+#define MaxTraceThreads	32767		// traceIds must fit in a short
+
+//----------------------------------------------------------------------
+// Tracer::Tracer
+// 	Initialize the tracer, with an empty buffer.
+//
+//	"name" -- the UNIX file to write the trace to, at Save
+//----------------------------------------------------------------------
+
+Tracer::Tracer(char *name)
+{
+    fileName = name;
+    ring = new TraceRecord[TraceBufferSize];
+    next = 0;
+    maxThreads = 16;
+    threadNames = new char *[maxThreads];
+    numThreads = 0;
+}
+
+//----------------------------------------------------------------------
+// Tracer::~Tracer
+// 	De-allocate the buffer and the thread names.
+//----------------------------------------------------------------------
+
+Tracer::~Tracer()
+{
+    for (int i = 0; i < numThreads; i++)
+	delete [] threadNames[i];
+    delete [] threadNames;
+    delete [] ring;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Record
+// 	Put an event in the buffer, over the oldest one once the buffer
+//	is full.
+//
+//	"event" -- what happened
+//	"arg" -- what it happened to (see TraceEvent)
+//----------------------------------------------------------------------
+
+void
+Tracer::Record(TraceEvent event, int arg)
+{
+    TraceRecord *record = &ring[next++ % TraceBufferSize];
+
+    record->ticks = stats->totalTicks;
+    record->event = event;
+    record->thread = (currentThread != NULL) ? currentThread->getTraceId() : 0;
+    record->arg = arg;
+}
+
+//----------------------------------------------------------------------
+// Tracer::NewThread
+// 	Remember the name of a new thread, and return the number it goes
+//	by in the trace.  Numbers are never reused, so the timeline of a
+//	thread that finishes isn't mixed up with a later one's.
+//
+//	"name" -- the thread's debug name
+//----------------------------------------------------------------------
+
+int
+Tracer::NewThread(char *name)
+{
+    char **names;
+
+    if (numThreads == MaxTraceThreads)
+	return 0;			// too many; trace it as nobody
+    if (numThreads == maxThreads) {
+	maxThreads *= 2;
+	names = new char *[maxThreads];
+	for (int i = 0; i < numThreads; i++)
+	    names[i] = threadNames[i];
+	delete [] threadNames;
+	threadNames = names;
+    }
+    if (name == NULL)
+	name = "(no name)";
+    threadNames[numThreads] = new char[strlen(name) + 1];
+    strcpy(threadNames[numThreads], name);
+    return ++numThreads;
+}
+
+//----------------------------------------------------------------------
+// Tracer::Save
+// 	Write the thread names and the events in the buffer, oldest
+//	first, to the trace file.
+//----------------------------------------------------------------------
+
+void
+Tracer::Save()
+{
+    int fd = OpenForWrite(fileName);
+    int numRecords = (next < TraceBufferSize) ? next : TraceBufferSize;
+    unsigned int first = next - numRecords;
+    int header[3], length, inFirstPart;
+
+    header[0] = TraceMagic;
+    header[1] = numThreads;
+    header[2] = numRecords;
+    WriteFile(fd, (char *) header, sizeof(header));
+    for (int i = 0; i < numThreads; i++) {
+	length = strlen(threadNames[i]);
+	WriteFile(fd, (char *) &length, sizeof(int));
+	WriteFile(fd, threadNames[i], length);
+    }
+
+    // the records run from "first" to the end of the ring, then wrap
+    inFirstPart = min(numRecords,
+			TraceBufferSize - (int) (first % TraceBufferSize));
+    WriteFile(fd, (char *) &ring[first % TraceBufferSize],
+					inFirstPart * sizeof(TraceRecord));
+    if (numRecords > inFirstPart)
+	WriteFile(fd, (char *) ring,
+			(numRecords - inFirstPart) * sizeof(TraceRecord));
+    Close(fd);
+    DEBUG('t', "Wrote %d trace events to %s\n", numRecords, fileName);
+}
+
+//----------------------------------------------------------------------
+// WriteName
+// 	Write a name as a JSON string, leaving out the characters that
+//	would need escaping -- they don't show up in debug names anyway.
+//----------------------------------------------------------------------
+
+static void
+WriteName(FILE *fp, char *name)
+{
+    fputc('"', fp);
+    for (; *name != '\0'; name++)
+	if ((*name != '"') && (*name != '\\') && (*name >= ' '))
+	    fputc(*name, fp);
+    fputc('"', fp);
+}
+
+//----------------------------------------------------------------------
+// TraceToJson
+// 	Convert a trace file to the Chrome trace event format.  Threads
+//	are in process 1, each with its own timeline, showing when it ran;
+//	interrupts, system calls and page faults are marked on the
+//	timeline of the thread that was running.  Disk requests are on a
+//	timeline of their own, in process 2.  A tick is shown as a
+//	microsecond.
+//
+//	"traceFile" -- the trace, as written by Tracer::Save
+//	"jsonFile" -- where to write the converted trace
+//----------------------------------------------------------------------
+
+void
+TraceToJson(char *traceFile, char *jsonFile)
+{
+    int fd = OpenForReadWrite(traceFile, TRUE);
+    FILE *fp;
+    int header[3], length, i, running = -1, lastTicks = 0;
+    bool diskBusy = FALSE;
+    char **names;
+    TraceRecord *records, *r;
+
+    Read(fd, (char *) header, sizeof(header));
+    ASSERT(header[0] == TraceMagic);
+    names = new char *[header[1] + 1];
+    names[0] = "(none)";
+    for (i = 1; i <= header[1]; i++) {
+	Read(fd, (char *) &length, sizeof(int));
+	names[i] = new char[length + 1];
+	Read(fd, names[i], length);
+	names[i][length] = '\0';
+    }
+    records = new TraceRecord[header[2]];
+    Read(fd, (char *) records, header[2] * sizeof(TraceRecord));
+    Close(fd);
+
+    fp = fopen(jsonFile, "w");
+    ASSERT(fp != NULL);
+    fprintf(fp, "{\"traceEvents\": [\n");
+    fprintf(fp, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, "
+	"\"args\": {\"name\": \"threads\"}},\n");
+    fprintf(fp, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, "
+	"\"args\": {\"name\": \"devices\"}},\n");
+    fprintf(fp, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 2, "
+	"\"tid\": 1, \"args\": {\"name\": \"disk\"}}");
+    for (i = 0; i <= header[1]; i++) {
+	fprintf(fp, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", "
+	    "\"pid\": 1, \"tid\": %d, \"args\": {\"name\": ", i);
+	WriteName(fp, names[i]);
+	fprintf(fp, "}}");
+    }
+
+    // the thread that was running when the trace starts
+    if (header[2] > 0) {
+	running = records[0].thread;
+	fprintf(fp, ",\n{\"name\": \"running\", \"ph\": \"B\", "
+	    "\"pid\": 1, \"tid\": %d, \"ts\": %d}", running,
+	    records[0].ticks);
+    }
+    for (i = 0; i < header[2]; i++) {
+	r = &records[i];
+	lastTicks = r->ticks;
+	switch (r->event) {
+	  case TraceSwitch:		// "thread" stops, "arg" starts
+	    if (running == r->thread)
+		fprintf(fp, ",\n{\"name\": \"running\", \"ph\": \"E\", "
+		    "\"pid\": 1, \"tid\": %d, \"ts\": %d}", r->thread,
+		    r->ticks);
+	    running = r->arg;
+	    fprintf(fp, ",\n{\"name\": \"running\", \"ph\": \"B\", "
+		"\"pid\": 1, \"tid\": %d, \"ts\": %d}", r->arg, r->ticks);
+	    break;
+	  case TraceInterrupt:
+	    fprintf(fp, ",\n{\"name\": \"%s interrupt\", \"ph\": \"i\", "
+		"\"s\": \"t\", \"pid\": 1, \"tid\": %d, \"ts\": %d}",
+		intTypeNames[r->arg], r->thread, r->ticks);
+	    break;
+	  case TraceDiskRead:
+	  case TraceDiskWrite:
+	    fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"B\", \"pid\": 2, "
+		"\"tid\": 1, \"ts\": %d, \"args\": {\"sector\": %d}}",
+		(r->event == TraceDiskRead) ? "read" : "write", r->ticks,
+		r->arg);
+	    diskBusy = TRUE;
+	    break;
+	  case TraceDiskDone:
+	    if (diskBusy)		// unless it started before the trace
+		fprintf(fp, ",\n{\"ph\": \"E\", \"pid\": 2, \"tid\": 1, "
+		    "\"ts\": %d}", r->ticks);
+	    diskBusy = FALSE;
+	    break;
+	  case TraceSyscall:
+	    fprintf(fp, ",\n{\"name\": \"syscall %d\", \"ph\": \"i\", "
+		"\"s\": \"t\", \"pid\": 1, \"tid\": %d, \"ts\": %d}",
+		r->arg, r->thread, r->ticks);
+	    break;
+	  case TracePageFault:
+	    fprintf(fp, ",\n{\"name\": \"page fault\", \"ph\": \"i\", "
+		"\"s\": \"t\", \"pid\": 1, \"tid\": %d, \"ts\": %d, "
+		"\"args\": {\"address\": %d}}", r->thread, r->ticks, r->arg);
+	    break;
+	}
+    }
+    if (running >= 0)
+	fprintf(fp, ",\n{\"name\": \"running\", \"ph\": \"E\", \"pid\": 1, "
+	    "\"tid\": %d, \"ts\": %d}", running, lastTicks);
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+
+    printf("Converted %d trace events, %d threads, to %s\n", header[2],
+	header[1], jsonFile);
+    for (i = 1; i <= header[1]; i++)
+	delete [] names[i];
+    delete [] names;
+    delete [] records;
+}
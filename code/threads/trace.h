@@ -0,0 +1,88 @@
+// trace.h
+//	Data structures to trace what the kernel and the machine do, for
+//	looking at afterwards with a trace viewer.
+//
+//	With tracing on (nachos -tr <file>), each trace point puts a small
+//	fixed-size record -- the simulated time, the event, the running
+//	thread and one number -- into a ring buffer in memory, keeping
+//	the most recent TraceBufferSize events.  Nothing is formatted
+//	while Nachos runs; the buffer is written out in binary when it
+//	halts, and "nachos -tc <trace file> <json file>" turns it into
+//	the Chrome trace format, with a timeline for each thread and one
+//	for the disk.
+//
+//	Trace points cost a test of "tracer" when tracing is off, and
+//	nothing at all when Nachos is compiled with -DNOTRACE.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The events that get traced, and what the number recorded with each is
+enum TraceEvent {
+    TraceSwitch,		// context switch; the thread switched to
+    TraceInterrupt,		// interrupt handler called; the IntType
+    TraceDiskRead,		// disk request sent; the sector
+    TraceDiskWrite,
+    TraceDiskDone,		// disk request finished; the sector
+    TraceSyscall,		// system call; its code
+    TracePageFault		// page fault; the faulting address
+};
+
+#define TraceBufferSize		(1 << 16)	// events kept; a power of two
+#define TraceMagic		0x4e545243	// "NTRC", starts a trace file
+
+#ifdef NOTRACE
+#define TRACE(event, arg)
+#else
+#define TRACE(event, arg)						\
+    if (tracer != NULL)							\
+	tracer->Record(event, (int) (arg))
+#endif
+
+// The following class defines one traced event, as kept in the buffer
+// and written to the trace file.
+
+class TraceRecord {
+  public:
+    int ticks;			// when it happened
+    short event;		// TraceEvent
+    short thread;		// Thread::traceId of the running thread
+    int arg;			// what the event is about
+};
+
+// The following class defines the tracer: the ring buffer, and the
+// names of the threads in it.
+
+class Tracer {
+  public:
+    Tracer(char *name);		// Trace into the UNIX file "name"
+    ~Tracer();			// De-allocate the buffer
+
+    void Record(TraceEvent event, int arg);
+				// Note that "event" happened now
+    int NewThread(char *name);	// Return the traceId for a new thread
+    void Save();		// Write the buffer out to the trace file
+
+  private:
+    char *fileName;		// where to write the trace
+    TraceRecord *ring;		// the most recent events
+    unsigned int next;		// events so far; the next one goes in
+				// ring[next % TraceBufferSize]
+    char **threadNames;		// by traceId, starting from 1
+    int numThreads;		// ... how many there are
+    int maxThreads;		// ... and room for
+};
+
+extern Tracer *tracer;		// NULL unless tracing (-tr)
+
+extern void TraceToJson(char *traceFile, char *jsonFile);
+				// Convert a trace to Chrome's format
+
+#endif // TRACE_H
@@ -1,6 +1,8 @@
 // utility.cc 
 //	Debugging routines.  Allows users to control whether to 
 //	print DEBUG statements, based on a command line argument.
+//	Also logging routines, which do the same for LOG statements,
+//	by subsystem and level.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,6 +18,12 @@
 
 static char *enableFlags = NULL; // controls which DEBUG messages are printed 
 
+LogLevel logLevels[NumLogSubsystems] = { LogError, LogError };
+				// controls which LOG messages are printed
+
+static char *logSubsystemNames[NumLogSubsystems] = { "files", "dirs" };
+static char *logLevelNames[] = { "off", "error", "info", "verbose" };
+
 //----------------------------------------------------------------------
 // DebugInit
 //      Initialize so that only DEBUG messages with a flag in flagList 
@@ -66,3 +74,74 @@ DEBUG(char flag, char *format, ...)
 	fflush(stdout);
     }
 }
+
+//----------------------------------------------------------------------
+// LogInit
+//      Set the level of LOG messages printed for each subsystem.
+//
+//	"spec" is a comma-separated list of "subsystem=level", where the
+//		subsystem is one of logSubsystemNames or "all", and the
+//		level one of logLevelNames.  A level on its own is for
+//		every subsystem.  Subsystems not mentioned keep logging
+//		errors only.
+//----------------------------------------------------------------------
+
+void
+LogInit(char *spec)
+{
+    char *item, *levelName, *end;
+    int length, i, level;
+
+    for (item = spec; *item != '\0'; item = (*end == ',') ? end + 1 : end) {
+	end = strchr(item, ',');
+	if (end == NULL)
+	    end = item + strlen(item);
+	levelName = strchr(item, '=');
+	if ((levelName == NULL) || (levelName > end))
+	    levelName = item;			// just a level: all of them
+	else
+	    levelName++;
+
+	length = end - levelName;
+	for (level = LogVerbose; level >= 0; level--)
+	    if (((int) strlen(logLevelNames[level]) == length)
+			&& !strncmp(levelName, logLevelNames[level], length))
+		break;
+	if (level < 0) {
+	    fprintf(stderr, "Unknown log level in \"%s\"\n", spec);
+	    Exit(1);
+	}
+
+	length = (levelName == item) ? 0 : levelName - 1 - item;
+	if ((length == 0) || ((length == 3) && !strncmp(item, "all", 3)))
+	    for (i = 0; i < NumLogSubsystems; i++)
+		logLevels[i] = (LogLevel) level;
+	else {
+	    for (i = 0; i < NumLogSubsystems; i++)
+		if (((int) strlen(logSubsystemNames[i]) == length)
+			&& !strncmp(item, logSubsystemNames[i], length))
+		    break;
+	    if (i == NumLogSubsystems) {
+		fprintf(stderr, "Unknown log subsystem in \"%s\"\n", spec);
+		Exit(1);
+	    }
+	    logLevels[i] = (LogLevel) level;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// LogPrint
+//      Print a log message; LOG has already checked its level.  Like
+//	printf.
+//----------------------------------------------------------------------
+
+void
+LogPrint(char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    vfprintf(stdout, format, ap);
+    va_end(ap);
+}
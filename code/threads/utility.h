@@ -16,6 +16,13 @@
 //   	'a' -- address spaces (USER_PROGRAM)
 //   	'n' -- network emulation (NETWORK)
 //
+//	Subsystems that report what they do as a matter of course (not
+//	just when debugging) log it with LOG instead, at a level: errors,
+//	information, or a message on every call.  The level of each
+//	subsystem is set from the command line (-lv); by default only
+//	errors are printed.  A LOG that is turned off costs one test, and
+//	its arguments are not even evaluated.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -47,8 +54,14 @@
 //
 // This is used by Thread::Fork and for interrupt handlers, as well
 // as a couple of other places.
+//
+// The argument is an "intptr_t" rather than an "int", since callers
+// routinely pass an object pointer through it (eg, "(intptr_t) this"),
+// and a pointer does not fit in an int on a 64-bit host.
+
+#include <stdint.h>
 
-typedef void (*VoidFunctionPtr)(int arg); 
+typedef void (*VoidFunctionPtr)(intptr_t arg); 
 typedef void (*VoidNoArgFunctionPtr)(); 
 
 
@@ -65,6 +78,27 @@ extern bool DebugIsEnabled(char flag); 	// Is this debug flag enabled?
 extern void DEBUG (char flag, char* format, ...);  	// Print debug message 
 							// if flag is enabled
 
+// Interface to logging routines.
+
+enum LogLevel { LogOff, LogError, LogInfo, LogVerbose };
+
+enum LogSubsystem {
+    LogFiles,			// file system: files ("files")
+    LogDirectories,		// file system: directories ("dirs")
+    NumLogSubsystems
+};
+
+extern LogLevel logLevels[NumLogSubsystems];	// how much each one logs
+
+extern void LogInit(char *spec);	// set the levels, from eg.
+					// "files=verbose,dirs=off"
+
+extern void LogPrint(char *format, ...);	// Print a log message
+
+#define LOG(subsystem, level, args)					\
+    if (logLevels[subsystem] >= (level))				\
+	LogPrint args
+
 //----------------------------------------------------------------------
 // ASSERT
 //      If condition is false,  print a message and dump core.
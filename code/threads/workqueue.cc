@@ -0,0 +1,137 @@
+// workqueue.cc
+//	Routines to queue work for a pool of kernel threads.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "workqueue.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// WorkerThread
+// 	The procedure each worker thread runs.  Dummy function because
+//	C++ does not allow a pointer to a member function.
+//----------------------------------------------------------------------
+
+static void
+WorkerThread(intptr_t queue)
+{
+    ((WorkQueue *) queue)->Work();
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::WorkQueue
+// 	Initialize an empty work queue, and fork its worker threads.
+//
+//	"debugName" -- name of the queue, and of its workers
+//	"howManyWorkers" -- how many workers; at most that many pieces of
+//		the queue's work can be in progress at once
+//	"priority" -- the workers' thread priority (see
+//		Thread::setPriority)
+//----------------------------------------------------------------------
+
+WorkQueue::WorkQueue(char *debugName, int howManyWorkers, int priority)
+{
+    Thread *t;
+    int i;
+
+    ASSERT(howManyWorkers > 0);
+    name = debugName;
+    numWorkers = howManyWorkers;
+    work = new SynchList;
+    lock = new Lock(debugName);
+    pending = 0;
+    allDone = new Condition(debugName);
+    stopped = new Semaphore(debugName, 0);
+
+    for (i = 0; i < numWorkers; i++) {
+	t = new Thread(debugName);
+	t->setPriority(priority);
+	t->Fork(WorkerThread, (intptr_t) this);
+    }
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::~WorkQueue
+// 	Wait for the queued work to be done, stop the workers and
+//	de-allocate the queue.
+//----------------------------------------------------------------------
+
+WorkQueue::~WorkQueue()
+{
+    int i;
+
+    Flush();
+    for (i = 0; i < numWorkers; i++)
+	work->Append(new WorkItem(NULL, 0, NULL));
+    for (i = 0; i < numWorkers; i++)
+	stopped->P();
+
+    delete work;
+    delete lock;
+    delete allDone;
+    delete stopped;
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::Queue
+// 	Queue a call of (*func)(arg), to be made by the first free
+//	worker.  Calls are started in the order they are queued, but
+//	with several workers, they may finish in any order.
+//
+//	"done" -- if not NULL, a semaphore to V once the call returns,
+//		so the caller can wait for this piece of work in particular
+//----------------------------------------------------------------------
+
+void
+WorkQueue::Queue(VoidFunctionPtr func, intptr_t arg, Semaphore *done)
+{
+    lock->Acquire();
+    pending++;
+    lock->Release();
+    work->Append(new WorkItem(func, arg, done));
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::Flush
+// 	Wait until the queue has no work left, queued or in progress.
+//----------------------------------------------------------------------
+
+void
+WorkQueue::Flush()
+{
+    lock->Acquire();
+    while (pending > 0)
+	allDone->Wait(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// WorkQueue::Work
+// 	Take work off the queue and do it, one piece at a time, until an
+//	item with no procedure to call says to stop.
+//----------------------------------------------------------------------
+
+void
+WorkQueue::Work()
+{
+    WorkItem *item;
+
+    while ((item = (WorkItem *) work->Remove())->func != NULL) {
+	DEBUG('t', "Worker of \"%s\" calling %p(%ld)\n", name,
+					(void *) item->func, (long) item->arg);
+	(*item->func)(item->arg);
+	if (item->done != NULL)
+	    item->done->V();
+	delete item;
+
+	lock->Acquire();
+	if (--pending == 0)
+	    allDone->Broadcast(lock);
+	lock->Release();
+    }
+    delete item;
+    stopped->V();
+}
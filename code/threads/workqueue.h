@@ -0,0 +1,67 @@
+// workqueue.h
+//	Data structures for handing work off to a pool of kernel threads.
+//
+//	Background activities -- flushing, prefetching, retransmitting --
+//	would each need a thread of their own, forked for the occasion.
+//	Instead, they can queue a procedure call on a work queue, to be
+//	made by whichever of the queue's worker threads is free.  The
+//	workers run at the priority of their queue, so urgent work can
+//	get a queue of its own, ahead of the rest.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "synch.h"
+#include "synchlist.h"
+
+// The following class defines one piece of queued work: a call to make,
+// and whom to tell when it is done.
+
+class WorkItem {
+  public:
+    WorkItem(VoidFunctionPtr f, intptr_t a, Semaphore *d) {
+	func = f; arg = a; done = d;
+    }
+
+    VoidFunctionPtr func;	// the procedure to call
+    intptr_t arg;		// ... and its argument
+    Semaphore *done;		// V'ed once the call returns, if not NULL
+};
+
+// The following class defines a work queue, and its pool of workers.
+
+class WorkQueue {
+  public:
+    WorkQueue(char *debugName, int howManyWorkers, int priority);
+				// Start "howManyWorkers" threads, running at
+				// "priority", to do the work queued here
+    ~WorkQueue();		// Finish the queued work, then stop the
+				// workers
+
+    void Queue(VoidFunctionPtr func, intptr_t arg, Semaphore *done = NULL);
+				// Have a worker call (*func)(arg), then
+				// V "done", if any
+    void Flush();		// Wait until all the work queued so far,
+				// and since, is done
+
+    void Work();		// Do queued work, until told to stop.
+				// Called internally, by each worker
+
+  private:
+    char *name;			// for debugging
+    int numWorkers;		// the worker threads
+    SynchList *work;		// the queued WorkItems; one with a NULL
+				// "func" tells a worker to stop
+    Lock *lock;			// protects "pending"
+    int pending;		// work queued but not yet done
+    Condition *allDone;		// signaled when "pending" drops to 0
+    Semaphore *stopped;		// V'ed by each worker as it stops
+};
+
+#endif // WORKQUEUE_H
@@ -115,6 +115,18 @@ AddrSpace::AddrSpace(FileHandle executable)
 
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+// 	Create an address space with no pages at all.  Used when
+//	resuming a program from a checkpoint; Restore fills it in.
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace()
+{
+    pageTable = NULL;
+    numPages = 0;
+}
+
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
 // 	Dealloate an address space.  Nothing for now!
@@ -181,3 +193,31 @@ void AddrSpace::RestoreState()
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
 }
+
+//----------------------------------------------------------------------
+// AddrSpace::Checkpoint
+// 	Save the page table to the open UNIX file "fd".  The pages
+//	themselves are in machine->mainMemory, which the machine saves.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Checkpoint(int fd)
+{
+    WriteFile(fd, (char *) &numPages, sizeof(unsigned int));
+    WriteFile(fd, (char *) pageTable, numPages * sizeof(TranslationEntry));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Restore
+// 	Replace the page table with the one saved by Checkpoint.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Restore(int fd)
+{
+    delete [] pageTable;
+    Read(fd, (char *) &numPages, sizeof(unsigned int));
+    ASSERT(numPages <= NumPhysPages);
+    pageTable = new TranslationEntry[numPages];
+    Read(fd, (char *) pageTable, numPages * sizeof(TranslationEntry));
+}
@@ -24,6 +24,8 @@ class AddrSpace {
    AddrSpace(FileHandle executable);	// Create an address space,
 					// initializing it with the program
 					// stored in the file "executable"
+    AddrSpace();			// Create an empty address space,
+					// to be filled in by Restore
     ~AddrSpace();			// De-allocate an address space
 
     void InitRegisters();		// Initialize user-level CPU registers,
@@ -32,6 +34,9 @@ class AddrSpace {
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
 
+    void Checkpoint(int fd);		// Save/restore the page table
+    void Restore(int fd);		// to/from an open UNIX file
+
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
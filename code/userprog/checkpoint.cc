@@ -0,0 +1,136 @@
+// checkpoint.cc
+//	Routines to save the state of a running user program, and the
+//	simulated machine underneath it, to a UNIX file, and to resume
+//	the program from that file later -- as many times as we like.
+//
+//	A checkpoint is taken between two user instructions (see
+//	Machine::Run), so the only kernel thread that matters is the one
+//	running the user program; its kernel state is just its address
+//	space.  Other threads live on host stacks we have no way of
+//	saving, so there must be none ready to run.
+//
+//	The file holds, in order:
+//		a magic number, whether there is a disk image, and the
+//		size of the statistics
+//		the address space's page table
+//		the CPU registers, physical memory and TLB
+//		the raw disk, if the file system is real (FILESYS)
+//		the position of the random number generator (-rs)
+//		the pending interrupts
+//		the statistics
+//
+//	Restoring a checkpoint puts all of these back, so the run
+//	continues exactly as the original one did from that point on,
+//	provided Nachos is started with the same flags (the same devices
+//	must exist to take back their pending interrupts).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "addrspace.h"
+
+#define CheckpointMagic	0x4e434b51	// to recognize a checkpoint file;
+					// change it when the format changes
+
+#ifdef FILESYS
+#define HasDiskImage	1
+#else
+#define HasDiskImage	0
+#endif
+
+//----------------------------------------------------------------------
+// TakeCheckpoint
+// 	Save the state of the simulation to the UNIX file "name".
+//	Called by the machine simulation between two user instructions.
+//----------------------------------------------------------------------
+
+void
+TakeCheckpoint(char *name)
+{
+    int magic = CheckpointMagic;
+    int hasDisk = HasDiskImage;
+    int statsSize = sizeof(Statistics);
+    unsigned seed;
+    int calls;
+    int fd;
+
+    ASSERT(scheduler->IsEmpty());	// can't save other threads' stacks
+    DEBUG('a', "Saving checkpoint to %s at time %d\n", name,
+	stats->totalTicks);
+
+    fd = OpenForWrite(name);
+    WriteFile(fd, (char *) &magic, sizeof(int));
+    WriteFile(fd, (char *) &hasDisk, sizeof(int));
+    WriteFile(fd, (char *) &statsSize, sizeof(int));
+    currentThread->space->Checkpoint(fd);
+    machine->Checkpoint(fd);
+#ifdef FILESYS
+    synchDisk->Checkpoint(fd);
+#endif
+    RandomGetState(&seed, &calls);
+    WriteFile(fd, (char *) &seed, sizeof(unsigned));
+    WriteFile(fd, (char *) &calls, sizeof(int));
+    interrupt->Checkpoint(fd);
+    WriteFile(fd, (char *) stats, sizeof(Statistics));
+    Close(fd);
+}
+
+//----------------------------------------------------------------------
+// RestoreProcess
+// 	Resume a user program from the checkpoint in the UNIX file
+//	"name", in place of loading it from an executable.
+//----------------------------------------------------------------------
+
+void
+RestoreProcess(char *name)
+{
+    int magic, hasDisk, statsSize;
+    unsigned seed;
+    int calls;
+    bool keepInstrMix, keepDiskLatency;
+    int fd = OpenForReadWrite(name, FALSE);
+    AddrSpace *space;
+
+    if (fd < 0) {
+	printf("Unable to open checkpoint %s\n", name);
+	return;
+    }
+    Read(fd, (char *) &magic, sizeof(int));
+    Read(fd, (char *) &hasDisk, sizeof(int));
+    Read(fd, (char *) &statsSize, sizeof(int));
+    if ((magic != CheckpointMagic) || (hasDisk != HasDiskImage)
+		|| (statsSize != (int) sizeof(Statistics))) {
+	printf("%s is not a checkpoint taken by this version of Nachos\n",
+	    name);
+	Close(fd);
+	return;
+    }
+
+    space = new AddrSpace();
+    space->Restore(fd);
+    currentThread->space = space;
+    space->RestoreState();		// load page table register
+    machine->Restore(fd);
+#ifdef FILESYS
+    synchDisk->Restore(fd);
+#endif
+    Read(fd, (char *) &seed, sizeof(unsigned));
+    Read(fd, (char *) &calls, sizeof(int));
+    RandomSetState(seed, calls);
+    interrupt->Restore(fd);
+    keepInstrMix = stats->keepInstrMix;	// those are up to this run
+    keepDiskLatency = stats->keepDiskLatency;
+    Read(fd, (char *) stats, sizeof(Statistics));
+    stats->keepInstrMix = keepInstrMix;
+    stats->keepDiskLatency = keepDiskLatency;
+    currentThread->ResetTimes();	// the clock has changed under it
+    Close(fd);
+
+    DEBUG('a', "Resuming from checkpoint %s at time %d\n", name,
+	stats->totalTicks);
+    machine->Run();			// jump back into the user program
+    ASSERT(FALSE);			// machine->Run never returns
+}
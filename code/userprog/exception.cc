@@ -53,6 +53,11 @@ ExceptionHandler(ExceptionType which)
 {
     int type = machine->ReadRegister(2);
 
+    if (which == SyscallException) {
+	TRACE(TraceSyscall, type);
+    } else if (which == PageFaultException) {
+	TRACE(TracePageFault, machine->ReadRegister(BadVAddrReg));
+    }
     if ((which == SyscallException) && (type == SC_Halt)) {
 	DEBUG('a', "Shutdown, initiated by user program.\n");
    	interrupt->Halt();
@@ -0,0 +1,271 @@
+// fusetest.cc
+//	Test routines for the fusion of common user instruction pairs
+//	(see Machine::ExecutePair), and for running user code from
+//	translated blocks (see Machine::RunTranslated, and -j).
+//
+//	Each test is a few hand-assembled MIPS instructions, run by the
+//	interpreter with fusion turned off and with it on, and then from
+//	translated blocks, with fusion on.  Every run must leave exactly
+//	the same registers (pending delayed load included) and take
+//	exactly the same number of ticks, and the register the test is
+//	about must hold the expected value.  The runs with fusion on must
+//	also have fused the pair -- except when an interrupt is due
+//	between the two instructions.
+//
+//	The code is put at the end of the first page, and the page after
+//	it is left invalid, so translated code stops where the test ends.
+//
+//	Run with "nachos -ft", without -rs: random timer interrupts
+//	would (rightly) stop some of the pairs from being fused.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "blockcache.h"
+
+// MIPS instruction encodings
+
+#define R(funct, rs, rt, rd, shamt) \
+	(((rs) << 21) | ((rt) << 16) | ((rd) << 11) | ((shamt) << 6) | (funct))
+#define I(op, rs, rt, imm) \
+	(((op) << 26) | ((rs) << 21) | ((rt) << 16) | ((imm) & 0xffff))
+
+#define ADDU(rd, rs, rt)	R(0x21, rs, rt, rd, 0)
+#define SUBU(rd, rs, rt)	R(0x23, rs, rt, rd, 0)
+#define AND(rd, rs, rt)		R(0x24, rs, rt, rd, 0)
+#define XOR(rd, rs, rt)		R(0x26, rs, rt, rd, 0)
+#define SLT(rd, rs, rt)		R(0x2a, rs, rt, rd, 0)
+#define SLTU(rd, rs, rt)	R(0x2b, rs, rt, rd, 0)
+#define SLL(rd, rt, sa)		R(0x00, 0, rt, rd, sa)
+#define NOP			SLL(0, 0, 0)
+#define BEQ(rs, rt, off)	I(4, rs, rt, off)
+#define BNE(rs, rt, off)	I(5, rs, rt, off)
+#define ADDIU(rt, rs, imm)	I(9, rs, rt, imm)
+#define SLTI(rt, rs, imm)	I(10, rs, rt, imm)
+#define SLTIU(rt, rs, imm)	I(11, rs, rt, imm)
+#define ANDI(rt, rs, imm)	I(12, rs, rt, imm)
+#define ORI(rt, rs, imm)	I(13, rs, rt, imm)
+#define LUI(rt, imm)		I(15, 0, rt, imm)
+#define LW(rt, off, rs)		I(0x23, rs, rt, off)
+
+#define DataAddr	0x100		// where LW finds its word
+#define DataValue	77		// ... and what it finds there
+
+// Before each test, r8 = 12, r9 = 10, r10 = -1 and the rest are 0.
+// The taken branches skip one instruction: r11 ends up 5 if taken,
+// 7 if not.
+
+struct FuseCase {
+    char *name;
+    int code[5];
+    int numInstrs;
+    int checkReg;		// the register to look at afterwards
+    int expected;		// ... and the value it should hold
+    bool interruptBetween;	// make an interrupt due after the first
+				// instruction, so the pair can't be fused
+};
+
+static FuseCase fuseCases[] = {
+    { "lui+ori", { LUI(8, 0x1234), ORI(8, 8, 0x5678), NOP }, 3,
+	8, 0x12345678, FALSE },
+    { "lui+addiu", { LUI(9, 1), ADDIU(9, 9, -1), NOP }, 3,
+	9, 0xffff, FALSE },
+    { "lw+addu", { LW(8, DataAddr, 0), ADDU(9, 8, 8), NOP }, 3,
+	9, 24, FALSE },				// sees r8 before the load
+    { "lw+nop", { LW(8, DataAddr, 0), NOP, ADDU(9, 8, 8) }, 3,
+	9, 2 * DataValue, FALSE },
+    { "lw+addiu", { LW(8, DataAddr, 0), ADDIU(8, 8, 1), NOP }, 3,
+	8, DataValue, FALSE },			// the load lands last
+    { "lw+subu", { LW(10, DataAddr, 0), SUBU(11, 8, 9), NOP }, 3,
+	11, 2, FALSE },
+    { "lw+and", { LW(10, DataAddr, 0), AND(11, 8, 9), NOP }, 3,
+	11, 8, FALSE },
+    { "lw+andi", { LW(10, DataAddr, 0), ANDI(11, 8, 6), NOP }, 3,
+	11, 4, FALSE },
+    { "lw+xor", { LW(10, DataAddr, 0), XOR(11, 8, 9), NOP }, 3,
+	11, 6, FALSE },
+    { "lw+slt", { LW(10, DataAddr, 0), SLT(11, 9, 10), NOP }, 3,
+	11, 0, FALSE },				// 10 < -1 is false
+    { "lw+sltu", { LW(10, DataAddr, 0), SLTU(11, 9, 10), NOP }, 3,
+	11, 1, FALSE },				// but 10 < 0xffffffff
+    { "lw+sll", { LW(10, DataAddr, 0), SLL(11, 8, 2), NOP }, 3,
+	11, 48, FALSE },
+    { "slt+bne", { SLT(10, 9, 8), BNE(10, 0, 2), ADDIU(11, 0, 1),
+	ADDIU(11, 11, 2), ADDIU(11, 11, 4) }, 5, 11, 5, FALSE },
+    { "sltu+beq", { SLTU(10, 9, 8), BEQ(10, 0, 2), ADDIU(11, 0, 1),
+	ADDIU(11, 11, 2), ADDIU(11, 11, 4) }, 5, 11, 7, FALSE },
+    { "slti+bne", { SLTI(10, 8, 13), BNE(10, 0, 2), ADDIU(11, 0, 1),
+	ADDIU(11, 11, 2), ADDIU(11, 11, 4) }, 5, 11, 5, FALSE },
+    { "sltiu+beq", { SLTIU(10, 8, 5), BEQ(0, 10, 2), ADDIU(11, 0, 1),
+	ADDIU(11, 11, 2), ADDIU(11, 11, 4) }, 5, 11, 5, FALSE },
+    { "lui+ori, interrupted", { LUI(8, 0x1234), ORI(8, 8, 0x5678), NOP }, 3,
+	8, 0x12345678, TRUE },
+};
+
+#define NumFuseCases	((int) (sizeof(fuseCases) / sizeof(FuseCase)))
+
+static int interruptsSeen;
+
+//----------------------------------------------------------------------
+// CountInterrupt
+// 	Interrupt handler for the "interrupted" test.
+//----------------------------------------------------------------------
+
+static void
+CountInterrupt(intptr_t arg)
+{
+    interruptsSeen++;
+}
+
+//----------------------------------------------------------------------
+// RunCase
+// 	Load the instructions of one test at the end of the first page
+//	and run them, as Machine::Run would, until the PC falls off the
+//	end.
+//
+//	"test" -- the instructions to run
+//	"fuse" -- whether to fuse instruction pairs
+//	"translated" -- whether to run from translated blocks
+//	"regs" -- where to leave the registers at the end
+//	"ticks", "fused" -- where to leave how much simulated time the
+//		test took, and how many pairs were fused
+//----------------------------------------------------------------------
+
+static void
+RunCase(FuseCase *test, bool fuse, bool translated, int *regs, int *ticks,
+	int *fused)
+{
+    Instruction *instr = new Instruction;
+    int startTicks = stats->totalTicks;
+    int startFused = stats->numFusedPairs;
+    int codeAddr = PageSize - test->numInstrs * 4;
+    int i;
+
+    bzero(machine->mainMemory, DataAddr + 4);
+    for (i = 0; i < test->numInstrs; i++)
+	*(unsigned int *) &machine->mainMemory[codeAddr + i * 4] =
+					WordToMachine(test->code[i]);
+    *(unsigned int *) &machine->mainMemory[DataAddr] =
+					WordToMachine(DataValue);
+
+    for (i = 0; i < NumTotalRegs; i++)
+	machine->WriteRegister(i, 0);
+    machine->WriteRegister(8, 12);
+    machine->WriteRegister(9, 10);
+    machine->WriteRegister(10, -1);
+    machine->WriteRegister(PCReg, codeAddr);
+    machine->WriteRegister(NextPCReg, codeAddr + 4);
+
+    machine->fuseInstructions = fuse;
+    interruptsSeen = 0;
+    if (test->interruptBetween)
+	interrupt->Schedule(CountInterrupt, 0, 1, TimerInt);
+
+    interrupt->setStatus(UserMode);
+    while (machine->ReadRegister(PCReg) != PageSize) {
+	if (!translated || !machine->RunTranslated())
+	    machine->OneInstruction(instr);
+	interrupt->OneTick();
+    }
+    interrupt->setStatus(SystemMode);
+    if (test->interruptBetween)
+	ASSERT(interruptsSeen == 1);
+
+    for (i = 0; i < NumTotalRegs; i++)
+	regs[i] = machine->ReadRegister(i);
+    *ticks = stats->totalTicks - startTicks;
+    *fused = stats->numFusedPairs - startFused;
+    delete instr;
+}
+
+//----------------------------------------------------------------------
+// CheckCase
+// 	Check a run of a test against the one with fusion off, and
+//	print what is wrong with it, if anything.  Returns TRUE if
+//	nothing is.
+//
+//	"how" -- what the run was, for the message
+//	"regs", "ticks", "fused" -- what the run left, as from RunCase
+//	"slowRegs", "slowTicks" -- what the run with fusion off left
+//----------------------------------------------------------------------
+
+static bool
+CheckCase(FuseCase *test, char *how, int *regs, int ticks, int fused,
+	int *slowRegs, int slowTicks)
+{
+    if (bcmp((char *) slowRegs, (char *) regs, NumTotalRegs * sizeof(int)))
+	printf("%s %s: registers differ from the unfused run\n", how,
+	    test->name);
+    else if (slowTicks != ticks)
+	printf("%s %s: took %d ticks, unfused %d\n", how, test->name,
+	    ticks, slowTicks);
+    else if (regs[test->checkReg] != test->expected)
+	printf("%s %s: r%d is 0x%x, should be 0x%x\n", how, test->name,
+	    test->checkReg, regs[test->checkReg], test->expected);
+    else if (fused != (test->interruptBetween ? 0 : 1))
+	printf("%s %s: %d pairs fused\n", how, test->name, fused);
+    else
+	return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// FuseTest
+// 	Run every test with fusion off and on, and check that both
+//	give the expected, and the same, results.
+//----------------------------------------------------------------------
+
+void
+FuseTest()
+{
+    TranslationEntry *pageTable = new TranslationEntry[NumPhysPages];
+    TranslationEntry *savedTable = machine->pageTable;
+    unsigned int savedSize = machine->pageTableSize;
+    bool savedFuse = machine->fuseInstructions;
+    BlockCache *savedCache = machine->blockCache;
+    int slowRegs[NumTotalRegs], fastRegs[NumTotalRegs];
+    int blockRegs[NumTotalRegs];
+    int slowTicks, fastTicks, blockTicks, slowFused, fastFused, blockFused;
+    int i, passed = 0;
+    FuseCase *test;
+
+    ASSERT(machine->tlb == NULL);	// needs the linear page table
+    for (i = 0; i < NumPhysPages; i++) {	// virtual = physical
+	pageTable[i].virtualPage = pageTable[i].physicalPage = i;
+	pageTable[i].valid = TRUE;
+	pageTable[i].use = pageTable[i].dirty = FALSE;
+	pageTable[i].readOnly = FALSE;
+    }
+    pageTable[1].valid = FALSE;		// where the code runs off to
+    machine->pageTable = pageTable;
+    machine->pageTableSize = NumPhysPages;
+    machine->blockCache = new BlockCache(machine->mainMemory);
+
+    for (i = 0; i < NumFuseCases; i++) {
+	test = &fuseCases[i];
+	RunCase(test, FALSE, FALSE, slowRegs, &slowTicks, &slowFused);
+	RunCase(test, TRUE, FALSE, fastRegs, &fastTicks, &fastFused);
+	RunCase(test, TRUE, TRUE, blockRegs, &blockTicks, &blockFused);
+
+	if (slowFused != 0)
+	    printf("Unfused %s: %d pairs fused\n", test->name, slowFused);
+	else if (CheckCase(test, "Fused", fastRegs, fastTicks, fastFused,
+							slowRegs, slowTicks)
+		&& CheckCase(test, "Translated", blockRegs, blockTicks,
+					blockFused, slowRegs, slowTicks)) {
+	    printf("Fused %s: ok\n", test->name);
+	    passed++;
+	}
+    }
+    printf("Fusion test: %d of %d passed\n", passed, NumFuseCases);
+
+    machine->pageTable = savedTable;
+    machine->pageTableSize = savedSize;
+    machine->fuseInstructions = savedFuse;
+    delete machine->blockCache;
+    machine->blockCache = savedCache;
+    delete [] pageTable;
+}
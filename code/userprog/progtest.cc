@@ -59,8 +59,8 @@ static Semaphore *writeDone;
 // 	Wake up the thread that requested the I/O.
 //----------------------------------------------------------------------
 
-static void ReadAvail(int arg) { readAvail->V(); }
-static void WriteDone(int arg) { writeDone->V(); }
+static void ReadAvail(intptr_t arg) { readAvail->V(); }
+static void WriteDone(intptr_t arg) { writeDone->V(); }
 
 //----------------------------------------------------------------------
 // ConsoleTest
@@ -2,13 +2,13 @@
 #include "sync_console.h"
 
 
-static void ConsoleReadDone(int arg)
+static void ConsoleReadDone(intptr_t arg)
 {
 	SyncConsole * console = (SyncConsole *) arg;
 	console->ReadDone();
 }
 
-static void ConsoleWriteDone(int arg)
+static void ConsoleWriteDone(intptr_t arg)
 {
 	SyncConsole * console = (SyncConsole *) arg;
 	console->WriteDone();
@@ -23,7 +23,7 @@ SyncConsole::SyncConsole(char * readname, char * writename)
 	readlock = new Lock("sync console lock read");
 	writelock = new Lock("sync console lock write");
 	console = new Console(NULL, NULL, ConsoleReadDone, ConsoleWriteDone,
-					(int) this);
+					(intptr_t) this);
 }
 
 SyncConsole::~SyncConsole()